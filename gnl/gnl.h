@@ -27,6 +27,7 @@
 
 #include "gnlobject.h"
 #include "gnlghostpad.h"
+#include "gnlintervaltree.h"
 #include "gnlsource.h"
 #include "gnlcomposition.h"
 #include "gnloperation.h"
@@ -51,6 +51,21 @@ enum
 {
   PROP_0,
   PROP_DEACTIVATED_ELEMENTS_STATE,
+  PROP_LOOKAHEAD,
+  PROP_PREFETCH_ZONES,
+  PROP_PREFETCH_BUDGET,
+  PROP_PREFETCH_HITS,
+  PROP_PREFETCH_MISSES,
+  PROP_PAUSED_CACHE_SIZE,
+  PROP_PAUSED_CACHE_MAX_BYTES,
+  PROP_PAUSED_CACHE_OBJECT_SIZE,
+  PROP_SHARED_SCHEDULER,
+  PROP_PARALLEL_ACTIVATION,
+  PROP_COALESCE_SEEKS,
+  PROP_DROPPED_SEEKS,
+  PROP_GAPLESS,
+  PROP_SEGMENT_CHAINING,
+  PROP_TRICKMODE_RATE,
   PROP_LAST,
 };
 
@@ -66,25 +81,33 @@ enum
 enum
 {
   COMMIT_SIGNAL,
+  GET_CUT_LIST_SIGNAL,
+  BEGIN_TRANSACTION_SIGNAL,
+  END_TRANSACTION_SIGNAL,
+  ADD_OBJECTS_SIGNAL,
+  REMOVE_OBJECTS_SIGNAL,
+  COMMIT_ASYNC_SIGNAL,
+  COMMITED_SIGNAL,
   LAST_SIGNAL
 };
 
 typedef struct _GnlCompositionEntry GnlCompositionEntry;
+typedef struct _GnlCutZone GnlCutZone;
+typedef struct _GnlTimelineSnapshot GnlTimelineSnapshot;
 
 struct _GnlCompositionPrivate
 {
   gboolean dispose_has_run;
 
   /*
-     Sorted List of GnlObjects , ThreadSafe
-     objects_start : sorted by start-time then priority
-     objects_stop : sorted by stop-time then priority
+     Index of GnlObjects , ThreadSafe
      objects_hash : contains signal handlers id for controlled objects
-     objects_lock : mutex to acces/modify any of those lists/hashtable
+     index : interval tree of the (non-expandable) objects, sorted by
+       start-time and by stop-time then priority
+     objects_lock : mutex to acces/modify the index/hashtable
    */
-  GList *objects_start;
-  GList *objects_stop;
   GHashTable *objects_hash;
+  GnlIntervalTree *index;
   GMutex objects_lock;
 
   /*
@@ -95,6 +118,46 @@ struct _GnlCompositionPrivate
   GMutex flushing_lock;
   gboolean flushing;
 
+  /*
+     Seek coalescing.
+     seek_lock : mutex to access the fields below
+     seeking : a seek pool thread is handling seeks
+     pending_seek : latest seek waiting for that thread, replacing the older
+                    ones which are counted in dropped_seeks
+   */
+  gboolean coalesce_seeks;
+  GMutex seek_lock;
+  gboolean seeking;
+  GstEvent *pending_seek;
+  guint64 dropped_seeks;
+
+  /* TRUE while handling a seek that has to be done on keyframes.
+   * Protected by OBJECTS_LOCK */
+  gboolean keyframe_seek;
+
+  /* Accurate seek to do once idle after a keyframe seek, with
+   * GNL_SEEK_ACCURACY_REFINE, the clock entry waiting for that, and the
+   * seqnum of the last such seek. Protected by seek_lock */
+  GstEvent *refine_seek;
+  GstClockID refine_id;
+  guint32 refine_seqnum;
+
+  /* Whether the stack switches at EOS are gapless, TRUE while doing such a
+   * switch, and the seqnum of the flushes to keep from going downstream
+   * (accessed atomically). Protected by OBJECTS_LOCK */
+  gboolean gapless;
+  gboolean gapless_switch;
+  gint gapless_seqnum;
+
+  /* Whether sources are seeked with segment seeks, so that the stack
+   * switches happen on SEGMENT_DONE instead of EOS. Protected by
+   * OBJECTS_LOCK */
+  gboolean segment_chaining;
+
+  /* Rate from which the sources are seeked in trick mode, 0.0 to never do
+   * so. Protected by OBJECTS_LOCK */
+  gdouble trickmode_rate;
+
   /* source top-level ghostpad, probe and entry */
   GstPad *ghostpad;
   gulong ghosteventprobe;
@@ -102,6 +165,16 @@ struct _GnlCompositionPrivate
 
   /* current stack, list of GnlObject* */
   GNode *current;
+  /* stack_fingerprint() of current */
+  guint64 current_fingerprint;
+
+  /* Cut list: GSequence of GnlCutZone covering the timeline, sorted by
+   * time. Built on the first seek, then kept up to date as objects are
+   * added, moved and removed, and the composition stop the expandables end
+   * at when it was last updated. NULL if not built. Protected by
+   * OBJECTS_LOCK */
+  GSequence *cutlist;
+  GstClockTime cutlist_stop;
 
   /* List of GnlObject whose start/duration will be the same as the composition */
   GList *expandables;
@@ -120,6 +193,44 @@ struct _GnlCompositionPrivate
   GstClockTime segment_start;
   GstClockTime segment_stop;
 
+  /* Nesting level of begin/end-transaction and the work deferred until
+   * the outermost end-transaction. Protected by OBJECTS_LOCK */
+  guint transaction_depth;
+  gboolean transaction_commit;
+  gboolean transaction_recurse;
+  gboolean transaction_update;
+  /* Whether the deferred commit was an asynchronous one, and
+   * #GnlComposition::commited has to be emitted once it's done.
+   * Protected by OBJECTS_LOCK */
+  gboolean transaction_notify;
+
+  /* Objects added during add-objects, indexed all at once at the end.
+   * Protected by OBJECTS_LOCK */
+  GPtrArray *pending_index;
+
+  /* Whether an asynchronous commit is queued and not started yet, and
+   * whether it has to recurse. Protected by OBJECTS_LOCK */
+  gboolean async_commit_queued;
+  gboolean async_commit_recurse;
+  /* Whether a pool thread is doing the asynchronous commits, so that they
+   * are done one at a time and in order, the thread while it commits, and
+   * whether an open transaction deferred that commit.
+   * Protected by OBJECTS_LOCK */
+  gboolean async_commit_running;
+  GThread *async_commit_thread;
+  gboolean async_commit_deferred;
+
+  /* Biggest stop and smallest start of the indexed sources, updated when
+   * commiting and removing objects. Protected by OBJECTS_LOCK, the
+   * streaming threads read them from the snapshot */
+  GstClockTime sources_max_stop;
+  GstClockTime sources_min_start;
+
+  /* Last published GnlTimelineSnapshot. snapshot_lock is only held to
+   * replace it or take a reference on it */
+  GnlTimelineSnapshot *snapshot;
+  GMutex snapshot_lock;
+
   /* pending child seek */
   GstEvent *childseek;
 
@@ -146,9 +257,46 @@ struct _GnlCompositionPrivate
 
   gboolean reset_time;
 
+  /* Whether pipeline updates are handled, between NULL->READY and
+   * READY->NULL. Accessed atomically */
   gboolean running;
 
+  /* Whether to run the pipeline updates from the shared scheduler instead
+   * of update_pipeline_thread, as requested and as used since NULL->READY,
+   * and the number of updates requested and not done yet */
+  gboolean shared_scheduler;
+  gboolean use_shared_scheduler;
+  gint pending_updates;
+
+  /* Whether to change the state of the objects of a new stack concurrently.
+   * Protected by OBJECTS_LOCK */
+  gboolean parallel_activation;
+
   GstState deactivated_elements_state;
+
+  /* Prefetching of the next stacks: whether to preroll the next stack,
+   * how many stacks ahead to preroll, at most how many objects, and the
+   * objects currently prerolled, nearest first, and their number.
+   * Protected by OBJECTS_LOCK */
+  gboolean lookahead;
+  guint prefetch_zones;
+  guint prefetch_budget;
+  GList *prerolled;
+  guint n_prerolled;
+
+  /* Number of stack switches for which all the new objects were (hits) or
+   * were not (misses) prerolled */
+  guint64 prefetch_hits;
+  guint64 prefetch_misses;
+
+  /* Objects that were recently used, kept in GST_STATE_PAUSED, most
+   * recently used first. Its capacity is paused_cache_size objects, and
+   * paused_cache_max_bytes given an estimated paused_cache_object_size
+   * per object. Protected by OBJECTS_LOCK */
+  GQueue paused_cache;
+  guint paused_cache_size;
+  guint64 paused_cache_max_bytes;
+  guint64 paused_cache_object_size;
 };
 
 static guint _signals[LAST_SIGNAL] = { 0 };
@@ -185,12 +333,36 @@ static inline void gnl_composition_remove_ghostpad (GnlComposition * comp);
 
 static gboolean
 seek_handling (GnlComposition * comp, gboolean initial, gboolean update);
-static gint objects_start_compare (GnlObject * a, GnlObject * b);
-static gint objects_stop_compare (GnlObject * a, GnlObject * b);
 static GstClockTime get_current_position (GnlComposition * comp);
 
 static gboolean update_pipeline (GnlComposition * comp,
     GstClockTime currenttime, gboolean initial, gboolean modify);
+static guint64 stack_fingerprint (GNode * stack);
+static void publish_snapshot (GnlComposition * comp, gboolean stable);
+static void request_update_pipeline (GnlComposition * comp);
+static void trim_paused_cache (GnlComposition * comp);
+static void cancel_refine (GnlComposition * comp);
+static GnlTimelineSnapshot *get_snapshot (GnlComposition * comp);
+static void timeline_snapshot_unref (GnlTimelineSnapshot * snapshot);
+static void invalidate_cut_list (GnlComposition * comp);
+static void ensure_cut_list (GnlComposition * comp);
+static void cut_list_invalidate (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop);
+static void cut_list_add_object (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop);
+static void cut_list_remove_object (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop);
+static void cut_list_move_object (GnlComposition * comp, GstClockTime oldstart,
+    GstClockTime oldstop, GstClockTime start, GstClockTime stop);
+static GArray *gnl_composition_get_cut_list (GnlComposition * comp);
+static void gnl_composition_begin_transaction (GnlComposition * comp);
+static gboolean gnl_composition_end_transaction (GnlComposition * comp);
+static gboolean gnl_composition_add_objects (GnlComposition * comp,
+    GPtrArray * objects);
+static gboolean gnl_composition_remove_objects (GnlComposition * comp,
+    GPtrArray * objects);
+static void gnl_composition_commit_async (GnlComposition * comp,
+    gboolean recurse);
 static void no_more_pads_object_cb (GstElement * element,
     GnlComposition * comp);
 static gboolean gnl_composition_commit_func (GnlObject * object,
@@ -273,6 +445,59 @@ struct _GnlCompositionEntry
   gulong dataprobeid;
 
   gboolean seeked;
+
+  /* TRUE if the object is in the prerolled list */
+  gboolean prerolled;
+
+  /* Seek the object got when prerolled for an upcoming zone, NULL if it
+   * wasn't prerolled or has been used since */
+  GstEvent *prerollseek;
+};
+
+/*
+ * GnlTimelineSnapshot:
+ *
+ * Immutable, refcounted view of the timeline published with OBJECTS_LOCK
+ * taken each time the stack or the sources change. The streaming threads
+ * use it to take decisions without waiting for an update of the pipeline
+ * to finish.
+ */
+struct _GnlTimelineSnapshot
+{
+  gint refcount;
+
+  /* FALSE while update_pipeline() is modifying the stack, in which case
+   * @stack is NULL and can't be relied upon */
+  gboolean stable;
+  /* Copy of the current stack */
+  GNode *stack;
+
+  GstClockTime segment_start;
+  GstClockTime segment_stop;
+  GstClockTime sources_max_stop;
+  GstClockTime sources_min_start;
+};
+
+struct _GnlCutZone
+{
+  /* [start, stop[ between two consecutive object boundaries, stop being
+   * the start of the next zone. The last zone only marks the end of the
+   * one before it */
+  GstClockTime start;
+
+  /* Number of object starts and stops at start */
+  guint starts;
+  guint stops;
+
+  /* What get_clean_toplevel_stack() returns anywhere in the zone: the
+   * stack, the start of the region it is valid in when going backward
+   * (GST_CLOCK_TIME_NONE if unknown) and its stop when going forward.
+   * Only valid if resolved is TRUE, which happens on the first lookup */
+  gboolean resolved;
+  GstClockTime stack_start;
+  GstClockTime stack_stop;
+  GNode *stack;
+  guint64 fingerprint;
 };
 
 static void
@@ -338,6 +563,196 @@ gnl_composition_class_init (GnlCompositionClass * klass)
       " be set", GST_TYPE_STATE, GST_STATE_READY,
       G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GnlComposition:lookahead
+   *
+   * Whether to preroll the objects of the stack following the one being
+   * played while it plays. The new objects are set to GST_STATE_PAUSED
+   * with their source pads blocked, and the new sources are seeked to the
+   * next zone before prerolling. Moving on to the next stack then only
+   * requires relinking them, and seeking the sources used through
+   * operations again.
+   *
+   * This is the same as setting #GnlComposition:prefetch-zones to 1.
+   */
+  _properties[PROP_LOOKAHEAD] =
+      g_param_spec_boolean ("lookahead", "Lookahead",
+      "Preroll the objects of the next stack while the current one plays",
+      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:prefetch-zones
+   *
+   * Number of stacks following the one being played whose objects should
+   * be prerolled, see #GnlComposition:lookahead.
+   */
+  _properties[PROP_PREFETCH_ZONES] =
+      g_param_spec_uint ("prefetch-zones", "Prefetch zones",
+      "Number of stacks ahead of the current one to preroll", 0, G_MAXUINT,
+      0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:prefetch-budget
+   *
+   * Maximum number of objects kept prerolled for the next stacks. When
+   * the budget is exceeded, the objects of the farthest stacks are put back
+   * in #GnlComposition:deactivated-elements-state first.
+   */
+  _properties[PROP_PREFETCH_BUDGET] =
+      g_param_spec_uint ("prefetch-budget", "Prefetch budget",
+      "Maximum number of objects prerolled ahead of the playhead", 0,
+      G_MAXUINT, G_MAXUINT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:prefetch-hits
+   *
+   * Number of times the composition moved on to the next stack at the end
+   * of the current one, and the new objects had all been prerolled. Seeks
+   * don't count.
+   */
+  _properties[PROP_PREFETCH_HITS] =
+      g_param_spec_uint64 ("prefetch-hits", "Prefetch hits",
+      "Number of stack changes for which the objects were prerolled", 0,
+      G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:prefetch-misses
+   *
+   * Number of times the composition moved on to the next stack at the end
+   * of the current one, and some new objects hadn't been prerolled, while
+   * prefetching was enabled. Seeks don't count.
+   */
+  _properties[PROP_PREFETCH_MISSES] =
+      g_param_spec_uint64 ("prefetch-misses", "Prefetch misses",
+      "Number of stack changes for which the objects weren't prerolled", 0,
+      G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:paused-cache-size
+   *
+   * Number of objects that stopped being used to keep in GST_STATE_PAUSED,
+   * the least recently used ones being set to
+   * #GnlComposition:deactivated-elements-state. This avoids tearing down
+   * and rebuilding the sources when going back and forth across a cut.
+   * 0 disables the cache.
+   */
+  _properties[PROP_PAUSED_CACHE_SIZE] =
+      g_param_spec_uint ("paused-cache-size", "Paused cache size",
+      "Number of recently used objects to keep in PAUSED", 0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:paused-cache-max-bytes
+   *
+   * Maximum memory the objects kept in GST_STATE_PAUSED should use, based
+   * on #GnlComposition:paused-cache-object-size. 0 means no limit.
+   */
+  _properties[PROP_PAUSED_CACHE_MAX_BYTES] =
+      g_param_spec_uint64 ("paused-cache-max-bytes", "Paused cache max bytes",
+      "Maximum estimated memory used by the objects kept in PAUSED "
+      "(0 = unlimited)", 0, G_MAXUINT64, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:paused-cache-object-size
+   *
+   * Estimated memory used by an object in GST_STATE_PAUSED, in bytes.
+   */
+  _properties[PROP_PAUSED_CACHE_OBJECT_SIZE] =
+      g_param_spec_uint64 ("paused-cache-object-size",
+      "Paused cache object size",
+      "Estimated memory used by an object in PAUSED, in bytes", 0,
+      G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:shared-scheduler
+   *
+   * Whether to update the pipeline when reaching the end of a stack from a
+   * small pool of threads shared by all the compositions of the process,
+   * instead of a thread of its own. The updates of a given composition are
+   * still done one after the other. Takes effect when going from
+   * GST_STATE_NULL to GST_STATE_READY.
+   */
+  _properties[PROP_SHARED_SCHEDULER] =
+      g_param_spec_boolean ("shared-scheduler", "Shared scheduler",
+      "Update the pipeline from threads shared by all the compositions",
+      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:parallel-activation
+   *
+   * Whether to set the objects of a new stack to their target state from
+   * several threads at once instead of one after the other, so that the
+   * time it takes to switch stacks depends on the slowest object rather
+   * than on all of them.
+   */
+  _properties[PROP_PARALLEL_ACTIVATION] =
+      g_param_spec_boolean ("parallel-activation", "Parallel activation",
+      "Activate the objects of a new stack concurrently", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:coalesce-seeks
+   *
+   * Whether the flushing seeks are handled from another thread, the event
+   * handler returning %TRUE at once. A seek received while another one is
+   * being handled replaces the previous seek still waiting, if any, instead
+   * of being handled after it. Useful when scrubbing from the thread
+   * running the user interface, where only the last position matters.
+   */
+  _properties[PROP_COALESCE_SEEKS] =
+      g_param_spec_boolean ("coalesce-seeks", "Coalesce seeks",
+      "Drop the pending seeks overtaken by newer ones", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:dropped-seeks
+   *
+   * Number of seeks dropped because of #GnlComposition:coalesce-seeks.
+   */
+  _properties[PROP_DROPPED_SEEKS] =
+      g_param_spec_uint64 ("dropped-seeks", "Dropped seeks",
+      "Number of seeks overtaken by newer ones", 0, G_MAXUINT64, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:gapless
+   *
+   * Whether moving on to the next stack when the current one is done
+   * happens without flushing downstream. Only a new segment event is then
+   * sent, so the downstream elements keep their data and clock sync across
+   * cuts. Seeks still flush.
+   */
+  _properties[PROP_GAPLESS] =
+      g_param_spec_boolean ("gapless", "Gapless",
+      "Do not flush downstream when switching stacks at EOS", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:segment-chaining
+   *
+   * Whether the stacks made of a single source, apart from the last one,
+   * are played with segment seeks. The next stack is then set up as soon
+   * as the source is done with its segment, without waiting for an EOS to
+   * go through it.
+   */
+  _properties[PROP_SEGMENT_CHAINING] =
+      g_param_spec_boolean ("segment-chaining", "Segment chaining",
+      "Switch stacks on segment-done instead of EOS", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlComposition:trickmode-rate
+   *
+   * Absolute playback rate from which the sources are seeked with
+   * GST_SEEK_FLAG_SKIP and GST_SEEK_FLAG_KEY_UNIT instead of accurately,
+   * letting them only decode keyframes. 0 disables trick mode.
+   */
+  _properties[PROP_TRICKMODE_RATE] =
+      g_param_spec_double ("trickmode-rate", "Trick mode rate",
+      "Absolute rate from which to only decode keyframes (0 = never)",
+      0.0, G_MAXDOUBLE, 0.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, _properties);
 
   /**
@@ -359,7 +774,132 @@ gnl_composition_class_init (GnlCompositionClass * klass)
       G_STRUCT_OFFSET (GnlObjectClass, commit_signal_handler), NULL, NULL, NULL,
       G_TYPE_BOOLEAN, 1, G_TYPE_BOOLEAN);
 
+  /**
+   * GnlComposition::get-cut-list
+   * @comp: a #GnlComposition
+   *
+   * Action signal to get the edit points of the composition, that is the
+   * sorted times at which the stack of objects being played changes, as of
+   * the last commit. The first value is the start of the first zone and the
+   * last value the end of the last zone.
+   *
+   * Returns: (transfer full): a #GArray of #GstClockTime
+   */
+  _signals[GET_CUT_LIST_SIGNAL] =
+      g_signal_new ("get-cut-list", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, get_cut_list), NULL, NULL, NULL,
+      G_TYPE_ARRAY, 0);
+
+  /**
+   * GnlComposition::begin-transaction
+   * @comp: a #GnlComposition
+   *
+   * Action signal to start a batch of edits. Until the matching
+   * #GnlComposition::end-transaction, commits are only recorded and
+   * removing objects that aren't being played doesn't update the pipeline.
+   * Transactions can be nested.
+   */
+  _signals[BEGIN_TRANSACTION_SIGNAL] =
+      g_signal_new ("begin-transaction", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, begin_transaction), NULL, NULL,
+      NULL, G_TYPE_NONE, 0);
+
+  /**
+   * GnlComposition::end-transaction
+   * @comp: a #GnlComposition
+   *
+   * Action signal to finish a batch of edits started with
+   * #GnlComposition::begin-transaction. When leaving the outermost
+   * transaction, the recorded commits are done at once, followed by a
+   * single duration and pipeline update.
+   *
+   * Returns: %TRUE if changes have been commited
+   */
+  _signals[END_TRANSACTION_SIGNAL] =
+      g_signal_new ("end-transaction", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, end_transaction), NULL, NULL,
+      NULL, G_TYPE_BOOLEAN, 0);
+
+  /**
+   * GnlComposition::add-objects
+   * @comp: a #GnlComposition
+   * @objects: a #GPtrArray of #GnlObject
+   *
+   * Action signal to add many objects at once. The objects are indexed in
+   * one go and the composition is commited once they are all added.
+   *
+   * Returns: %TRUE if all the objects could be added
+   */
+  _signals[ADD_OBJECTS_SIGNAL] =
+      g_signal_new ("add-objects", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, add_objects), NULL, NULL,
+      NULL, G_TYPE_BOOLEAN, 1, G_TYPE_PTR_ARRAY);
+
+  /**
+   * GnlComposition::remove-objects
+   * @comp: a #GnlComposition
+   * @objects: a #GPtrArray of #GnlObject
+   *
+   * Action signal to remove many objects at once. The objects are dropped
+   * from the index in one go and the composition is commited once they are
+   * all removed.
+   *
+   * Returns: %TRUE if all the objects could be removed
+   */
+  _signals[REMOVE_OBJECTS_SIGNAL] =
+      g_signal_new ("remove-objects", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, remove_objects), NULL, NULL,
+      NULL, G_TYPE_BOOLEAN, 1, G_TYPE_PTR_ARRAY);
+
+  /**
+   * GnlComposition::commit-async
+   * @comp: a #GnlComposition
+   * @recurse: Whether to commit recursively into (GnlComposition) children
+   *
+   * Action signal to commit the pending changes from another thread instead
+   * of blocking the caller while the pipeline gets updated. Commits
+   * requested while a previous one is still queued are merged into it.
+   * #GnlComposition::commited is emitted once the commit is done.
+   */
+  _signals[COMMIT_ASYNC_SIGNAL] =
+      g_signal_new ("commit-async", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GnlCompositionClass, commit_async), NULL, NULL,
+      NULL, G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
+
+  /**
+   * GnlComposition::commited
+   * @comp: a #GnlComposition
+   * @changed: %TRUE if changes have been commited
+   *
+   * Emitted once a commit requested with #GnlComposition::commit-async
+   * is done and the pipeline uses the new configuration. The asynchronous
+   * commits of a composition are done one at a time and in order, so the
+   * emissions follow the requests.
+   *
+   * It is emitted from the thread doing asynchronous commits, not from the
+   * thread that requested them, or from the thread ending the transaction
+   * when the commit was requested while a transaction was open and so had
+   * to wait for it.
+   */
+  _signals[COMMITED_SIGNAL] =
+      g_signal_new ("commited", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+      G_TYPE_BOOLEAN);
+
   gnlobject_class->commit = gnl_composition_commit_func;
+  klass->get_cut_list = GST_DEBUG_FUNCPTR (gnl_composition_get_cut_list);
+  klass->begin_transaction =
+      GST_DEBUG_FUNCPTR (gnl_composition_begin_transaction);
+  klass->end_transaction = GST_DEBUG_FUNCPTR (gnl_composition_end_transaction);
+  klass->add_objects = GST_DEBUG_FUNCPTR (gnl_composition_add_objects);
+  klass->remove_objects = GST_DEBUG_FUNCPTR (gnl_composition_remove_objects);
+  klass->commit_async = GST_DEBUG_FUNCPTR (gnl_composition_commit_async);
 }
 
 static void
@@ -387,6 +927,9 @@ hash_value_destroy (GnlCompositionEntry * entry)
     gst_object_unref (srcpad);
   }
 
+  if (entry->prerollseek)
+    gst_event_unref (entry->prerollseek);
+
   g_slice_free (GnlCompositionEntry, entry);
 }
 
@@ -401,11 +944,11 @@ gnl_composition_init (GnlComposition * comp)
   priv = G_TYPE_INSTANCE_GET_PRIVATE (comp, GNL_TYPE_COMPOSITION,
       GnlCompositionPrivate);
   g_mutex_init (&priv->objects_lock);
-  priv->objects_start = NULL;
-  priv->objects_stop = NULL;
 
   g_mutex_init (&priv->flushing_lock);
   priv->flushing = FALSE;
+  g_mutex_init (&priv->seek_lock);
+  g_mutex_init (&priv->snapshot_lock);
 
   priv->segment = gst_segment_new ();
   priv->outside_segment = gst_segment_new ();
@@ -417,8 +960,12 @@ gnl_composition_init (GnlComposition * comp)
   priv->objects_hash = g_hash_table_new_full
       (g_direct_hash,
       g_direct_equal, NULL, (GDestroyNotify) hash_value_destroy);
+  priv->index = gnl_interval_tree_new ();
+  priv->sources_max_stop = 0;
+  priv->sources_min_start = GST_CLOCK_TIME_NONE;
 
   priv->deactivated_elements_state = GST_STATE_READY;
+  priv->prefetch_budget = G_MAXUINT;
 
   comp->priv = priv;
 
@@ -448,12 +995,22 @@ gnl_composition_dispose (GObject * object)
     g_node_destroy (priv->current);
     priv->current = NULL;
   }
+  priv->current_fingerprint = 0;
+
+  invalidate_cut_list (comp);
 
   if (priv->expandables) {
     g_list_free (priv->expandables);
     priv->expandables = NULL;
   }
 
+  g_list_free (priv->prerolled);
+  priv->prerolled = NULL;
+  priv->n_prerolled = 0;
+  g_queue_clear (&priv->paused_cache);
+
+  cancel_refine (comp);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -466,18 +1023,22 @@ gnl_composition_finalize (GObject * object)
   GST_INFO ("finalize");
 
   COMP_OBJECTS_LOCK (comp);
-  g_list_free (priv->objects_start);
-  g_list_free (priv->objects_stop);
   if (priv->current)
     g_node_destroy (priv->current);
   g_hash_table_destroy (priv->objects_hash);
+  gnl_interval_tree_free (priv->index);
   COMP_OBJECTS_UNLOCK (comp);
 
+  if (priv->snapshot)
+    timeline_snapshot_unref (priv->snapshot);
+
   gst_segment_free (priv->segment);
   gst_segment_free (priv->outside_segment);
 
   g_mutex_clear (&priv->objects_lock);
   g_mutex_clear (&priv->flushing_lock);
+  g_mutex_clear (&priv->seek_lock);
+  g_mutex_clear (&priv->snapshot_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -492,6 +1053,67 @@ gnl_composition_set_property (GObject * object, guint prop_id,
     case PROP_DEACTIVATED_ELEMENTS_STATE:
       comp->priv->deactivated_elements_state = g_value_get_enum (value);
       break;
+    case PROP_LOOKAHEAD:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->lookahead = g_value_get_boolean (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PREFETCH_ZONES:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->prefetch_zones = g_value_get_uint (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PREFETCH_BUDGET:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->prefetch_budget = g_value_get_uint (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PAUSED_CACHE_SIZE:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->paused_cache_size = g_value_get_uint (value);
+      trim_paused_cache (comp);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PAUSED_CACHE_MAX_BYTES:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->paused_cache_max_bytes = g_value_get_uint64 (value);
+      trim_paused_cache (comp);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PAUSED_CACHE_OBJECT_SIZE:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->paused_cache_object_size = g_value_get_uint64 (value);
+      trim_paused_cache (comp);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_SHARED_SCHEDULER:
+      comp->priv->shared_scheduler = g_value_get_boolean (value);
+      break;
+    case PROP_PARALLEL_ACTIVATION:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->parallel_activation = g_value_get_boolean (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_COALESCE_SEEKS:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->coalesce_seeks = g_value_get_boolean (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_GAPLESS:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->gapless = g_value_get_boolean (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_SEGMENT_CHAINING:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->segment_chaining = g_value_get_boolean (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_TRICKMODE_RATE:
+      COMP_OBJECTS_LOCK (comp);
+      comp->priv->trickmode_rate = g_value_get_double (value);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -508,6 +1130,57 @@ gnl_composition_get_property (GObject * object, guint prop_id,
     case PROP_DEACTIVATED_ELEMENTS_STATE:
       g_value_set_enum (value, comp->priv->deactivated_elements_state);
       break;
+    case PROP_LOOKAHEAD:
+      g_value_set_boolean (value, comp->priv->lookahead);
+      break;
+    case PROP_PREFETCH_ZONES:
+      g_value_set_uint (value, comp->priv->prefetch_zones);
+      break;
+    case PROP_PREFETCH_BUDGET:
+      g_value_set_uint (value, comp->priv->prefetch_budget);
+      break;
+    case PROP_PAUSED_CACHE_SIZE:
+      g_value_set_uint (value, comp->priv->paused_cache_size);
+      break;
+    case PROP_PAUSED_CACHE_MAX_BYTES:
+      g_value_set_uint64 (value, comp->priv->paused_cache_max_bytes);
+      break;
+    case PROP_PAUSED_CACHE_OBJECT_SIZE:
+      g_value_set_uint64 (value, comp->priv->paused_cache_object_size);
+      break;
+    case PROP_SHARED_SCHEDULER:
+      g_value_set_boolean (value, comp->priv->shared_scheduler);
+      break;
+    case PROP_PARALLEL_ACTIVATION:
+      g_value_set_boolean (value, comp->priv->parallel_activation);
+      break;
+    case PROP_COALESCE_SEEKS:
+      g_value_set_boolean (value, comp->priv->coalesce_seeks);
+      break;
+    case PROP_DROPPED_SEEKS:
+      g_mutex_lock (&comp->priv->seek_lock);
+      g_value_set_uint64 (value, comp->priv->dropped_seeks);
+      g_mutex_unlock (&comp->priv->seek_lock);
+      break;
+    case PROP_GAPLESS:
+      g_value_set_boolean (value, comp->priv->gapless);
+      break;
+    case PROP_SEGMENT_CHAINING:
+      g_value_set_boolean (value, comp->priv->segment_chaining);
+      break;
+    case PROP_TRICKMODE_RATE:
+      g_value_set_double (value, comp->priv->trickmode_rate);
+      break;
+    case PROP_PREFETCH_HITS:
+      COMP_OBJECTS_LOCK (comp);
+      g_value_set_uint64 (value, comp->priv->prefetch_hits);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
+    case PROP_PREFETCH_MISSES:
+      COMP_OBJECTS_LOCK (comp);
+      g_value_set_uint64 (value, comp->priv->prefetch_misses);
+      COMP_OBJECTS_UNLOCK (comp);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -600,6 +1273,10 @@ reset_child (GValue * item, GValue * ret G_GNUC_UNUSED, gpointer user_data)
   if (entry->nomorepadshandler)
     wait_no_more_pads (comp, child, entry, FALSE);
 
+  /* It loses the position it was prerolled at */
+  entry->prerolled = FALSE;
+  gst_event_replace (&entry->prerollseek, NULL);
+
   return TRUE;
 }
 
@@ -648,8 +1325,15 @@ gnl_composition_reset (GnlComposition * comp)
   if (priv->current)
     g_node_destroy (priv->current);
   priv->current = NULL;
+  priv->current_fingerprint = 0;
 
   priv->stackvalid = FALSE;
+  publish_snapshot (comp, TRUE);
+
+  g_list_free (priv->prerolled);
+  priv->prerolled = NULL;
+  priv->n_prerolled = 0;
+  g_queue_clear (&priv->paused_cache);
 
   if (priv->ghostpad)
     gnl_composition_remove_ghostpad (comp);
@@ -668,6 +1352,7 @@ gnl_composition_reset (GnlComposition * comp)
   COMP_FLUSHING_UNLOCK (comp);
 
   priv->reset_time = FALSE;
+  g_atomic_int_set (&priv->gapless_seqnum, 0);
 
   priv->send_stream_start = TRUE;
 
@@ -681,12 +1366,24 @@ ghost_event_probe_handler (GstPad * ghostpad G_GNUC_UNUSED,
   GstPadProbeReturn retval = GST_PAD_PROBE_OK;
   GnlCompositionPrivate *priv = comp->priv;
   GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
-  GList *tmp;
 
   GST_DEBUG_OBJECT (comp, "event: %s", GST_EVENT_TYPE_NAME (event));
 
   switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      if (GST_EVENT_SEQNUM (event) ==
+          (guint32) g_atomic_int_get (&priv->gapless_seqnum)) {
+        GST_DEBUG_OBJECT (comp, "gapless switch, dropping flush start");
+        retval = GST_PAD_PROBE_DROP;
+      }
+      break;
     case GST_EVENT_FLUSH_STOP:
+      if (GST_EVENT_SEQNUM (event) ==
+          (guint32) g_atomic_int_get (&priv->gapless_seqnum)) {
+        GST_DEBUG_OBJECT (comp, "gapless switch, dropping flush stop");
+        retval = GST_PAD_PROBE_DROP;
+        break;
+      }
       GST_DEBUG_OBJECT (comp,
           "replacing flush stop event with a flush stop event with 'reset_time' = %d",
           priv->reset_time);
@@ -741,7 +1438,7 @@ ghost_event_probe_handler (GstPad * ghostpad G_GNUC_UNUSED,
     case GST_EVENT_EOS:
     {
       gboolean reverse = (comp->priv->segment->rate < 0);
-      gboolean should_check_objects = FALSE;
+      GnlTimelineSnapshot *snapshot;
 
       COMP_FLUSHING_LOCK (comp);
       if (priv->flushing) {
@@ -752,28 +1449,16 @@ ghost_event_probe_handler (GstPad * ghostpad G_GNUC_UNUSED,
       }
       COMP_FLUSHING_UNLOCK (comp);
 
-      if (reverse && GST_CLOCK_TIME_IS_VALID (comp->priv->segment_start))
-        should_check_objects = TRUE;
-      else if (!reverse && GST_CLOCK_TIME_IS_VALID (comp->priv->segment_stop))
-        should_check_objects = TRUE;
-
-      if (should_check_objects) {
-        retval = GST_PAD_PROBE_OK;
-        COMP_OBJECTS_LOCK (comp);
-        for (tmp = comp->priv->objects_stop; tmp; tmp = g_list_next (tmp)) {
-          GnlObject *object = (GnlObject *) tmp->data;
-
-          if (!GNL_IS_SOURCE (object))
-            continue;
-
-          if ((!reverse && comp->priv->segment_stop < object->stop) ||
-              (reverse && comp->priv->segment_start > object->start)) {
-            retval = GST_PAD_PROBE_DROP;
-            break;
-          }
-        }
-        COMP_OBJECTS_UNLOCK (comp);
-      }
+      /* Some sources go past the current segment, this EOS only means we
+       * have to move on to the next stack */
+      snapshot = get_snapshot (comp);
+      if (reverse && GST_CLOCK_TIME_IS_VALID (snapshot->segment_start) &&
+          snapshot->segment_start > snapshot->sources_min_start)
+        retval = GST_PAD_PROBE_DROP;
+      else if (!reverse && GST_CLOCK_TIME_IS_VALID (snapshot->segment_stop) &&
+          snapshot->segment_stop < snapshot->sources_max_stop)
+        retval = GST_PAD_PROBE_DROP;
+      timeline_snapshot_unref (snapshot);
 
       if (retval == GST_PAD_PROBE_OK) {
         GST_DEBUG_OBJECT (comp, "Got EOS for real, fowarding it");
@@ -781,9 +1466,30 @@ ghost_event_probe_handler (GstPad * ghostpad G_GNUC_UNUSED,
         return GST_PAD_PROBE_OK;
       }
 
-      SIGNAL_UPDATE_PIPELINE (comp);
+      request_update_pipeline (comp);
+
+      retval = GST_PAD_PROBE_DROP;
+    }
+      break;
+    case GST_EVENT_SEGMENT_DONE:
+    {
+      if (!priv->segment_chaining)
+        break;
 
+      /* The stack is done with the segment we seeked it to, the next stack
+       * (or our own segment-done) is for the update thread to set up */
       retval = GST_PAD_PROBE_DROP;
+
+      COMP_FLUSHING_LOCK (comp);
+      if (priv->flushing) {
+        GST_DEBUG_OBJECT (comp, "flushing, bailing out");
+        COMP_FLUSHING_UNLOCK (comp);
+        break;
+      }
+      COMP_FLUSHING_UNLOCK (comp);
+
+      GST_DEBUG_OBJECT (comp, "Got segment-done, moving on to the next stack");
+      request_update_pipeline (comp);
     }
       break;
     default:
@@ -829,7 +1535,17 @@ gnl_composition_handle_message (GstBin * bin, GstMessage * message)
             "HACK Dropping error message from object not in currently configured stack !");
         dropit = TRUE;
       }
+      break;
     }
+    case GST_MESSAGE_SEGMENT_START:
+    case GST_MESSAGE_SEGMENT_DONE:
+      /* The segments of the sources are ours, we post our own messages
+       * once the last stack is done */
+      if (comp->priv->segment_chaining) {
+        GST_DEBUG_OBJECT (comp, "Dropping segment message from a child");
+        dropit = TRUE;
+      }
+      break;
     default:
       break;
   }
@@ -892,87 +1608,480 @@ update_pipeline_at_current_position (GnlComposition * comp)
   return update_pipeline (comp, curpos, TRUE, TRUE);
 }
 
-static gboolean
-gnl_composition_commit_func (GnlObject * object, gboolean recurse)
+static GnlTimelineSnapshot *
+timeline_snapshot_ref (GnlTimelineSnapshot * snapshot)
 {
-  GList *tmp;
-  gboolean commited = FALSE;
-  GnlComposition *comp = GNL_COMPOSITION (object);
-  GnlCompositionPrivate *priv = comp->priv;
-
-
-  GST_DEBUG_OBJECT (object, "Commiting state");
-  COMP_OBJECTS_LOCK (comp);
-  for (tmp = priv->objects_start; tmp; tmp = tmp->next) {
-    if (gnl_object_commit (tmp->data, recurse))
-      commited = TRUE;
-  }
-
-  GST_DEBUG_OBJECT (object, "Linking up commit vmethod");
-  if (commited == FALSE &&
-      (GNL_OBJECT_CLASS (parent_class)->commit (object, recurse) == FALSE)) {
-    COMP_OBJECTS_UNLOCK (comp);
-    GST_DEBUG_OBJECT (object, "Nothing to commit, leaving");
-    return FALSE;
-  }
+  g_atomic_int_inc (&snapshot->refcount);
 
-  /* The topology of the composition might have changed, update the lists */
-  priv->objects_start = g_list_sort
-      (priv->objects_start, (GCompareFunc) objects_start_compare);
-  priv->objects_stop = g_list_sort
-      (priv->objects_stop, (GCompareFunc) objects_stop_compare);
+  return snapshot;
+}
 
-  /* And update the pipeline at current position if needed */
-  update_pipeline_at_current_position (comp);
-  COMP_OBJECTS_UNLOCK (comp);
+static void
+timeline_snapshot_unref (GnlTimelineSnapshot * snapshot)
+{
+  if (!g_atomic_int_dec_and_test (&snapshot->refcount))
+    return;
 
-  GST_DEBUG_OBJECT (object, "Done commiting");
-  return TRUE;
+  if (snapshot->stack)
+    g_node_destroy (snapshot->stack);
+  g_slice_free (GnlTimelineSnapshot, snapshot);
 }
 
 /*
- * get_new_seek_event:
+ * publish_snapshot:
+ * @stable: FALSE if the stack is about to be modified
  *
- * Returns a seek event for the currently configured segment
- * and start/stop values
+ * Replaces the snapshot used by the streaming threads with the current
+ * state of the composition.
  *
- * The GstSegment and segment_start|stop must have been configured
- * before calling this function.
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+publish_snapshot (GnlComposition * comp, gboolean stable)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GnlTimelineSnapshot *snapshot, *old;
+
+  snapshot = g_slice_new0 (GnlTimelineSnapshot);
+  snapshot->refcount = 1;
+  snapshot->stable = stable;
+  if (stable && priv->current)
+    snapshot->stack = g_node_copy (priv->current);
+  snapshot->segment_start = priv->segment_start;
+  snapshot->segment_stop = priv->segment_stop;
+  snapshot->sources_max_stop = priv->sources_max_stop;
+  snapshot->sources_min_start = priv->sources_min_start;
+
+  g_mutex_lock (&priv->snapshot_lock);
+  old = priv->snapshot;
+  priv->snapshot = snapshot;
+  g_mutex_unlock (&priv->snapshot_lock);
+
+  if (old)
+    timeline_snapshot_unref (old);
+}
+
+/*
+ * get_snapshot:
+ *
+ * Returns: (transfer full): The last published snapshot, release it with
+ * timeline_snapshot_unref(). Can be called without any lock.
+ */
+static GnlTimelineSnapshot *
+get_snapshot (GnlComposition * comp)
+{
+  GnlTimelineSnapshot *snapshot;
+
+  g_mutex_lock (&comp->priv->snapshot_lock);
+  snapshot = timeline_snapshot_ref (comp->priv->snapshot);
+  g_mutex_unlock (&comp->priv->snapshot_lock);
+
+  return snapshot;
+}
+
+typedef struct
+{
+  GnlComposition *comp;
+  gboolean recurse;
+  gboolean commited;
+  guint moved;
+
+  GstClockTime max_stop;
+  GstClockTime min_start;
+} CommitData;
+
+static void
+accumulate_source_extents (GnlObject * object, CommitData * data)
+{
+  if (!GNL_IS_SOURCE (object))
+    return;
+
+  data->max_stop = MAX (data->max_stop, object->stop);
+  data->min_start = MIN (data->min_start, object->start);
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+update_sources_extents (GnlComposition * comp)
+{
+  CommitData data = { comp, FALSE, FALSE, 0, 0, GST_CLOCK_TIME_NONE };
+
+  gnl_interval_tree_foreach (comp->priv->index,
+      (GFunc) accumulate_source_extents, &data);
+
+  comp->priv->sources_max_stop = data.max_stop;
+  comp->priv->sources_min_start = data.min_start;
+  publish_snapshot (comp, TRUE);
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+commit_child (GnlObject * object, CommitData * data)
+{
+  gboolean commited = gnl_object_commit (object, data->recurse);
+  GstClockTime oldstart, oldstop;
+
+  accumulate_source_extents (object, data);
+
+  if (!commited)
+    return;
+
+  data->commited = TRUE;
+
+  /* Only relocate the objects whose start/stop/priority really changed,
+   * the index still has the previous values */
+  if (gnl_interval_tree_lookup (data->comp->priv->index, object, &oldstart,
+          &oldstop) && gnl_interval_tree_update (data->comp->priv->index,
+          object)) {
+    data->moved++;
+    cut_list_move_object (data->comp, oldstart, oldstop, object->start,
+        object->stop);
+  } else {
+    /* The inpoint can still have changed the stacks */
+    cut_list_invalidate (data->comp, object->start, object->stop);
+  }
+}
+
+static gboolean
+gnl_composition_commit_func (GnlObject * object, gboolean recurse)
+{
+  GnlComposition *comp = GNL_COMPOSITION (object);
+  GnlCompositionPrivate *priv = comp->priv;
+  CommitData data = { comp, recurse, FALSE, 0, 0, GST_CLOCK_TIME_NONE };
+
+  GST_DEBUG_OBJECT (object, "Commiting state");
+  COMP_OBJECTS_LOCK (comp);
+  if (priv->transaction_depth) {
+    GST_DEBUG_OBJECT (object, "In a transaction, deferring commit");
+    priv->transaction_commit = TRUE;
+    priv->transaction_recurse |= recurse;
+    /* The asynchronous commit only gets done at the end of the transaction,
+     * that's where it has to be notified */
+    if (priv->async_commit_thread == g_thread_self ()) {
+      priv->async_commit_deferred = TRUE;
+      priv->transaction_notify = TRUE;
+    }
+    COMP_OBJECTS_UNLOCK (comp);
+    return TRUE;
+  }
+
+  gnl_interval_tree_foreach (priv->index, (GFunc) commit_child, &data);
+  GST_DEBUG_OBJECT (object, "%u objects moved in the timeline", data.moved);
+
+  priv->sources_max_stop = data.max_stop;
+  priv->sources_min_start = data.min_start;
+
+  GST_DEBUG_OBJECT (object, "Linking up commit vmethod");
+  if (data.commited == FALSE &&
+      (GNL_OBJECT_CLASS (parent_class)->commit (object, recurse) == FALSE)) {
+    COMP_OBJECTS_UNLOCK (comp);
+    GST_DEBUG_OBJECT (object, "Nothing to commit, leaving");
+    return FALSE;
+  }
+
+  /* And update the pipeline at current position if needed */
+  update_pipeline_at_current_position (comp);
+  publish_snapshot (comp, TRUE);
+  COMP_OBJECTS_UNLOCK (comp);
+
+  GST_DEBUG_OBJECT (object, "Done commiting");
+  return TRUE;
+}
+
+static void
+gnl_composition_begin_transaction (GnlComposition * comp)
+{
+  COMP_OBJECTS_LOCK (comp);
+  comp->priv->transaction_depth++;
+  GST_DEBUG_OBJECT (comp, "Transaction depth %u",
+      comp->priv->transaction_depth);
+  COMP_OBJECTS_UNLOCK (comp);
+}
+
+static gboolean
+gnl_composition_end_transaction (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean commit, recurse, update, notify, ret = FALSE;
+
+  COMP_OBJECTS_LOCK (comp);
+  if (G_UNLIKELY (priv->transaction_depth == 0)) {
+    COMP_OBJECTS_UNLOCK (comp);
+    GST_WARNING_OBJECT (comp, "end-transaction without begin-transaction");
+    return FALSE;
+  }
+
+  if (--priv->transaction_depth) {
+    COMP_OBJECTS_UNLOCK (comp);
+    return FALSE;
+  }
+
+  commit = priv->transaction_commit;
+  recurse = priv->transaction_recurse;
+  update = priv->transaction_update;
+  notify = priv->transaction_notify;
+  priv->transaction_commit = FALSE;
+  priv->transaction_recurse = FALSE;
+  priv->transaction_update = FALSE;
+  priv->transaction_notify = FALSE;
+  COMP_OBJECTS_UNLOCK (comp);
+
+  GST_DEBUG_OBJECT (comp, "Transaction done, commit:%d update:%d", commit,
+      update);
+
+  if (commit)
+    ret = gnl_object_commit (GNL_OBJECT (comp), recurse);
+
+  /* The commit already updated the pipeline */
+  if (update && !ret) {
+    COMP_OBJECTS_LOCK (comp);
+    update_pipeline_at_current_position (comp);
+    COMP_OBJECTS_UNLOCK (comp);
+  }
+
+  if (notify) {
+    GST_DEBUG_OBJECT (comp, "Deferred asynchronous commit done, ret:%d", ret);
+    g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, ret);
+  }
+
+  return ret;
+}
+
+static gboolean
+gnl_composition_add_objects (GnlComposition * comp, GPtrArray * objects)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GPtrArray *pending = NULL;
+  gboolean ret = TRUE;
+  guint i;
+
+  g_return_val_if_fail (objects != NULL, FALSE);
+
+  GST_DEBUG_OBJECT (comp, "Adding %u objects", objects->len);
+
+  gnl_composition_begin_transaction (comp);
+
+  COMP_OBJECTS_LOCK (comp);
+  if (!priv->pending_index)
+    pending = priv->pending_index = g_ptr_array_sized_new (objects->len);
+  COMP_OBJECTS_UNLOCK (comp);
+
+  for (i = 0; i < objects->len; i++) {
+    if (!gst_bin_add (GST_BIN (comp), g_ptr_array_index (objects, i)))
+      ret = FALSE;
+  }
+
+  /* Index everything that got added at once */
+  if (pending) {
+    COMP_OBJECTS_LOCK (comp);
+    gnl_interval_tree_insert_many (priv->index,
+        (GnlObject **) pending->pdata, pending->len);
+    for (i = 0; i < pending->len; i++) {
+      GnlObject *object = g_ptr_array_index (pending, i);
+
+      cut_list_add_object (comp, object->start, object->stop);
+    }
+    priv->pending_index = NULL;
+    COMP_OBJECTS_UNLOCK (comp);
+
+    g_ptr_array_free (pending, TRUE);
+  }
+
+  gnl_object_commit (GNL_OBJECT (comp), TRUE);
+  gnl_composition_end_transaction (comp);
+
+  return ret;
+}
+
+static gboolean
+gnl_composition_remove_objects (GnlComposition * comp, GPtrArray * objects)
+{
+  gboolean ret = TRUE;
+  guint i;
+
+  g_return_val_if_fail (objects != NULL, FALSE);
+
+  GST_DEBUG_OBJECT (comp, "Removing %u objects", objects->len);
+
+  gnl_composition_begin_transaction (comp);
+
+  /* Drop them from the index at once, so that the stacks resolved while
+   * removing them one by one don't use them */
+  COMP_OBJECTS_LOCK (comp);
+  for (i = 0; i < objects->len; i++) {
+    GstClockTime start, stop;
+
+    if (gnl_interval_tree_lookup (comp->priv->index,
+            g_ptr_array_index (objects, i), &start, &stop))
+      cut_list_remove_object (comp, start, stop);
+  }
+  if (gnl_interval_tree_remove_many (comp->priv->index,
+          (GnlObject **) objects->pdata, objects->len))
+    update_sources_extents (comp);
+  COMP_OBJECTS_UNLOCK (comp);
+
+  for (i = 0; i < objects->len; i++) {
+    if (!gst_bin_remove (GST_BIN (comp), g_ptr_array_index (objects, i)))
+      ret = FALSE;
+  }
+
+  gnl_object_commit (GNL_OBJECT (comp), TRUE);
+  gnl_composition_end_transaction (comp);
+
+  return ret;
+}
+
+/* Process-wide pool doing the asynchronous commits */
+static GThreadPool *commit_pool = NULL;
+
+static void
+commit_pool_func (GnlComposition * comp, gpointer udata)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean recurse, deferred, ret;
+
+  /* Do the commits queued while we are running ourselves, so that another
+   * pool thread never commits the same composition concurrently */
+  COMP_OBJECTS_LOCK (comp);
+  while (priv->async_commit_queued) {
+    /* Commits requested from now on need another run */
+    recurse = priv->async_commit_recurse;
+    priv->async_commit_queued = FALSE;
+    priv->async_commit_recurse = FALSE;
+    priv->async_commit_thread = g_thread_self ();
+    priv->async_commit_deferred = FALSE;
+    COMP_OBJECTS_UNLOCK (comp);
+
+    ret = gnl_object_commit (GNL_OBJECT (comp), recurse);
+
+    COMP_OBJECTS_LOCK (comp);
+    deferred = priv->async_commit_deferred;
+    priv->async_commit_thread = NULL;
+    priv->async_commit_deferred = FALSE;
+    COMP_OBJECTS_UNLOCK (comp);
+
+    /* A deferred commit gets notified by the end of the transaction */
+    if (deferred) {
+      GST_DEBUG_OBJECT (comp, "Asynchronous commit deferred");
+    } else {
+      GST_DEBUG_OBJECT (comp, "Asynchronous commit done, ret:%d", ret);
+      g_signal_emit (comp, _signals[COMMITED_SIGNAL], 0, ret);
+    }
+
+    COMP_OBJECTS_LOCK (comp);
+  }
+  priv->async_commit_running = FALSE;
+  COMP_OBJECTS_UNLOCK (comp);
+
+  gst_object_unref (comp);
+}
+
+static GThreadPool *
+get_commit_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    commit_pool = g_thread_pool_new ((GFunc) commit_pool_func, NULL,
+        g_get_num_processors (), FALSE, NULL);
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return commit_pool;
+}
+
+static void
+gnl_composition_commit_async (GnlComposition * comp, gboolean recurse)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean merged, queue;
+
+  COMP_OBJECTS_LOCK (comp);
+  merged = priv->async_commit_queued;
+  priv->async_commit_queued = TRUE;
+  priv->async_commit_recurse |= recurse;
+  /* The running pool thread picks it up when done with the current one */
+  queue = !priv->async_commit_running;
+  priv->async_commit_running = TRUE;
+  COMP_OBJECTS_UNLOCK (comp);
+
+  if (!queue) {
+    GST_DEBUG_OBJECT (comp, "%s", merged ?
+        "Merged into the queued asynchronous commit" :
+        "Queued after the running asynchronous commit");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (comp, "Queueing asynchronous commit");
+  g_thread_pool_push (get_commit_pool (), gst_object_ref (comp), NULL);
+}
+
+/*
+ * get_zone_seek_event:
+ * @stack: The stack to seek
+ * @zonestart: The start of the zone @stack is used over
+ * @zonestop: The stop of the zone @stack is used over
+ *
+ * Returns a seek event for @stack over the part of the configured segment
+ * covered by [@zonestart, @zonestop[
  */
 static GstEvent *
-get_new_seek_event (GnlComposition * comp, gboolean initial,
-    gboolean updatestoponly)
+get_zone_seek_event (GnlComposition * comp, GNode * stack, gboolean initial,
+    gboolean updatestoponly, GstClockTime zonestart, GstClockTime zonestop)
 {
-  GstSeekFlags flags = GST_SEEK_FLAG_ACCURATE | GST_SEEK_FLAG_FLUSH;
+  GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
   gint64 start, stop;
   GstSeekType starttype = GST_SEEK_TYPE_SET;
   GnlCompositionPrivate *priv = comp->priv;
 
+  if (priv->keyframe_seek)
+    flags |= GST_SEEK_FLAG_KEY_UNIT;
+  else
+    flags |= GST_SEEK_FLAG_ACCURATE;
+
   GST_DEBUG_OBJECT (comp, "initial:%d", initial);
   /* remove the seek flag */
   if (!initial)
     flags |= (GstSeekFlags) priv->segment->flags;
 
+  /* Fast enough for the sources to only decode keyframes */
+  if (priv->trickmode_rate > 0.0 &&
+      ABS (priv->segment->rate) >= priv->trickmode_rate) {
+    GST_DEBUG_OBJECT (comp, "rate %lf, seeking in trick mode",
+        priv->segment->rate);
+    flags &= ~GST_SEEK_FLAG_ACCURATE;
+    flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SKIP;
+  }
+
   GST_DEBUG_OBJECT (comp,
-      "private->segment->start:%" GST_TIME_FORMAT " segment_start%"
+      "private->segment->start:%" GST_TIME_FORMAT " zone start%"
       GST_TIME_FORMAT, GST_TIME_ARGS (priv->segment->start),
-      GST_TIME_ARGS (priv->segment_start));
+      GST_TIME_ARGS (zonestart));
 
   GST_DEBUG_OBJECT (comp,
-      "private->segment->stop:%" GST_TIME_FORMAT " segment_stop%"
+      "private->segment->stop:%" GST_TIME_FORMAT " zone stop%"
       GST_TIME_FORMAT, GST_TIME_ARGS (priv->segment->stop),
-      GST_TIME_ARGS (priv->segment_stop));
+      GST_TIME_ARGS (zonestop));
 
-  start = MAX (priv->segment->start, priv->segment_start);
+  start = MAX (priv->segment->start, zonestart);
   stop = GST_CLOCK_TIME_IS_VALID (priv->segment->stop)
-      ? MIN (priv->segment->stop, priv->segment_stop)
-      : priv->segment_stop;
+      ? MIN (priv->segment->stop, zonestop)
+      : zonestop;
 
   if (updatestoponly) {
     starttype = GST_SEEK_TYPE_NONE;
     start = GST_CLOCK_TIME_NONE;
   }
 
+  /* Sources of a zone which isn't the last one end with a segment-done
+   * instead of an EOS. Operations don't all forward segment-done, their
+   * stacks keep ending with EOS */
+  if (priv->segment_chaining && stack && G_NODE_IS_LEAF (stack)) {
+    if ((priv->segment->rate >= 0.0) ?
+        zonestop < priv->sources_max_stop : zonestart > priv->sources_min_start)
+      flags |= GST_SEEK_FLAG_SEGMENT;
+  }
+
   GST_DEBUG_OBJECT (comp,
       "Created new seek event. Flags:%d, start:%" GST_TIME_FORMAT ", stop:%"
       GST_TIME_FORMAT ", rate:%lf", flags, GST_TIME_ARGS (start),
@@ -982,6 +2091,33 @@ get_new_seek_event (GnlComposition * comp, gboolean initial,
       priv->segment->format, flags, starttype, start, GST_SEEK_TYPE_SET, stop);
 }
 
+/*
+ * get_new_seek_event:
+ *
+ * Returns a seek event for the currently configured segment
+ * and start/stop values
+ *
+ * The GstSegment and segment_start|stop must have been configured
+ * before calling this function.
+ */
+static GstEvent *
+get_new_seek_event (GnlComposition * comp, gboolean initial,
+    gboolean updatestoponly)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GstEvent *event;
+
+  event = get_zone_seek_event (comp, priv->current, initial, updatestoponly,
+      priv->segment_start, priv->segment_stop);
+
+  /* The new stack still has to be flushed, its flushes just don't go
+   * further than our ghostpad */
+  if (priv->gapless_switch)
+    g_atomic_int_set (&priv->gapless_seqnum, GST_EVENT_SEQNUM (event));
+
+  return event;
+}
+
 /* OBJECTS LOCK must be taken when calling this ! */
 static GstClockTime
 get_current_position (GnlComposition * comp)
@@ -1086,10 +2222,15 @@ seek_handling (GnlComposition * comp, gboolean initial, gboolean update)
 
   COMP_OBJECTS_LOCK (comp);
   if (update || have_to_update_pipeline (comp)) {
+    /* Seeks and EOS resolve the new stack from the cut list */
+    ensure_cut_list (comp);
+
+    comp->priv->gapless_switch = update && comp->priv->gapless;
     if (comp->priv->segment->rate >= 0.0)
       update_pipeline (comp, comp->priv->segment->start, initial, !update);
     else
       update_pipeline (comp, comp->priv->segment->stop, initial, !update);
+    comp->priv->gapless_switch = FALSE;
   } else {
     update_operations_base_time (comp, !(comp->priv->segment->rate >= 0.0));
   }
@@ -1133,45 +2274,336 @@ handle_seek_event (GnlComposition * comp, GstEvent * event)
   seek_handling (comp, TRUE, FALSE);
 }
 
-static gboolean
-gnl_composition_event_handler (GstPad * ghostpad, GstObject * parent,
-    GstEvent * event)
+/*
+ * Seek refinement
+ *
+ * With GNL_SEEK_ACCURACY_REFINE, each keyframe seek (re)starts a timer, and
+ * the accurate version of the last one is done from the refine pool once
+ * the timer expires. Starting playback or doing an accurate seek cancels
+ * it, the position is then either moving on or already accurate.
+ */
+#define REFINE_DELAY (150 * GST_MSECOND)
+
+static GThreadPool *refine_pool = NULL;
+
+static void
+refine_pool_func (GnlComposition * comp, gpointer udata)
 {
-  GnlComposition *comp = (GnlComposition *) parent;
   GnlCompositionPrivate *priv = comp->priv;
-  gboolean res = TRUE;
+  GstEvent *event;
+  GstPad *srcpad;
 
-  GST_DEBUG_OBJECT (comp, "event type:%s", GST_EVENT_TYPE_NAME (event));
+  g_mutex_lock (&priv->seek_lock);
+  event = priv->refine_seek;
+  priv->refine_seek = NULL;
+  g_mutex_unlock (&priv->seek_lock);
+
+  /* Handled like the seeks coming from downstream, a bin would only send
+   * it to its sinks */
+  if (event && (srcpad = gst_element_get_static_pad (GST_ELEMENT (comp),
+              "src"))) {
+    GST_DEBUG_OBJECT (comp, "Refining seek");
+    gst_pad_send_event (srcpad, event);
+    gst_object_unref (srcpad);
+  } else if (event) {
+    gst_event_unref (event);
+  }
 
-  switch (GST_EVENT_TYPE (event)) {
-    case GST_EVENT_SEEK:
-    {
-      GstEvent *nevent;
+  gst_object_unref (comp);
+}
 
-      handle_seek_event (comp, event);
+static GThreadPool *
+get_refine_pool (void)
+{
+  static gsize initialized = 0;
 
-      /* the incoming event might not be quite correct, we get a new proper
-       * event to pass on to the children. */
-      COMP_OBJECTS_LOCK (comp);
-      nevent = get_new_seek_event (comp, FALSE, FALSE);
-      COMP_OBJECTS_UNLOCK (comp);
-      gst_event_unref (event);
-      event = nevent;
-      priv->reset_time = TRUE;
-      break;
-    }
-    case GST_EVENT_QOS:
-    {
-      gdouble prop;
-      GstQOSType qostype;
-      GstClockTimeDiff diff;
-      GstClockTime timestamp;
+  if (g_once_init_enter (&initialized)) {
+    refine_pool = g_thread_pool_new ((GFunc) refine_pool_func, NULL, 1,
+        FALSE, NULL);
+    g_once_init_leave (&initialized, 1);
+  }
 
-      gst_event_parse_qos (event, &qostype, &prop, &diff, &timestamp);
+  return refine_pool;
+}
 
-      GST_INFO_OBJECT (comp,
-          "timestamp:%" GST_TIME_FORMAT " segment.start:%" GST_TIME_FORMAT
-          " segment.stop:%" GST_TIME_FORMAT " segment_start%" GST_TIME_FORMAT
+static gboolean
+refine_timeout_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean expired = FALSE;
+
+  g_mutex_lock (&priv->seek_lock);
+  if (priv->refine_id == id) {
+    gst_clock_id_unref (priv->refine_id);
+    priv->refine_id = NULL;
+    expired = TRUE;
+  }
+  g_mutex_unlock (&priv->seek_lock);
+
+  /* Seeking from the clock thread would hold up the other waits */
+  if (expired)
+    g_thread_pool_push (get_refine_pool (), gst_object_ref (comp), NULL);
+
+  return TRUE;
+}
+
+/* Sets up the accurate seek following the keyframe seek @event */
+static void
+schedule_refine (GnlComposition * comp, GstEvent * event)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GstFormat format;
+  gdouble rate;
+  GstSeekFlags flags;
+  GstSeekType curtype, stoptype;
+  gint64 cur, stop;
+  GstClock *clock;
+  GstEvent *refine;
+
+  gst_event_parse_seek (event, &rate, &format, &flags,
+      &curtype, &cur, &stoptype, &stop);
+  flags &= ~GST_SEEK_FLAG_KEY_UNIT;
+  refine = gst_event_new_seek (rate, format, flags | GST_SEEK_FLAG_ACCURATE,
+      curtype, cur, stoptype, stop);
+
+  g_mutex_lock (&priv->seek_lock);
+  if (priv->refine_id) {
+    gst_clock_id_unschedule (priv->refine_id);
+    gst_clock_id_unref (priv->refine_id);
+  }
+
+  gst_event_replace (&priv->refine_seek, NULL);
+  priv->refine_seek = refine;
+  priv->refine_seqnum = GST_EVENT_SEQNUM (refine);
+
+  clock = gst_system_clock_obtain ();
+  priv->refine_id = gst_clock_new_single_shot_id (clock,
+      gst_clock_get_time (clock) + REFINE_DELAY);
+  gst_clock_id_wait_async (priv->refine_id,
+      (GstClockCallback) refine_timeout_cb, gst_object_ref (comp),
+      (GDestroyNotify) gst_object_unref);
+  gst_object_unref (clock);
+  g_mutex_unlock (&priv->seek_lock);
+}
+
+/* Drops the accurate seek waiting to be done, if any */
+static void
+cancel_refine (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  g_mutex_lock (&priv->seek_lock);
+  if (priv->refine_id) {
+    GST_DEBUG_OBJECT (comp, "Cancelling seek refinement");
+    gst_clock_id_unschedule (priv->refine_id);
+    gst_clock_id_unref (priv->refine_id);
+    priv->refine_id = NULL;
+  }
+  gst_event_replace (&priv->refine_seek, NULL);
+  g_mutex_unlock (&priv->seek_lock);
+}
+
+/* Handles @event and returns the seek to pass on to the children */
+static GstEvent *
+prepare_seek (GnlComposition * comp, GstEvent * event)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GnlSeekAccuracy accuracy = GNL_OBJECT (comp)->seek_accuracy;
+  GstSeekFlags flags;
+  GstEvent *nevent;
+  gboolean keyframe = FALSE;
+
+  gst_event_parse_seek (event, NULL, NULL, &flags, NULL, NULL, NULL, NULL);
+
+  /* Only the flushing seeks, done when scrubbing, can land on a keyframe.
+   * The non-flushing ones happen while playing */
+  if (accuracy != GNL_SEEK_ACCURACY_ACCURATE && (flags & GST_SEEK_FLAG_FLUSH)) {
+    g_mutex_lock (&priv->seek_lock);
+    keyframe = (GST_EVENT_SEQNUM (event) != priv->refine_seqnum);
+    g_mutex_unlock (&priv->seek_lock);
+  }
+
+  if (keyframe && accuracy == GNL_SEEK_ACCURACY_REFINE)
+    schedule_refine (comp, event);
+  else if (!keyframe)
+    cancel_refine (comp);
+
+  COMP_OBJECTS_LOCK (comp);
+  priv->keyframe_seek = keyframe;
+  COMP_OBJECTS_UNLOCK (comp);
+
+  handle_seek_event (comp, event);
+
+  /* the incoming event might not be quite correct, we get a new proper
+   * event to pass on to the children. */
+  COMP_OBJECTS_LOCK (comp);
+  nevent = get_new_seek_event (comp, FALSE, FALSE);
+  priv->keyframe_seek = FALSE;
+  COMP_OBJECTS_UNLOCK (comp);
+  gst_event_unref (event);
+  priv->reset_time = TRUE;
+
+  return nevent;
+}
+
+static gboolean
+forward_event (GnlComposition * comp, GstObject * parent, GstEvent * event)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean res = TRUE;
+
+  if (priv->ghostpad) {
+    COMP_OBJECTS_LOCK (comp);
+
+    /* If the timeline isn't entirely reconstructed, we silently ignore the
+     * event. In the case of seeks the pipeline will already be correctly
+     * configured at this point*/
+    if (priv->waitingpads == 0) {
+      COMP_OBJECTS_UNLOCK (comp);
+      GST_DEBUG_OBJECT (comp, "About to call gnl_event_pad_func()");
+      res = priv->gnl_event_pad_func (priv->ghostpad, parent, event);
+      priv->reset_time = FALSE;
+      GST_DEBUG_OBJECT (comp, "Done calling gnl_event_pad_func() %d", res);
+    } else {
+      COMP_OBJECTS_UNLOCK (comp);
+      gst_event_unref (event);
+    }
+
+  }
+
+  return res;
+}
+
+/* Process-wide pool handling the coalesced seeks. The seeks block until
+ * the compositions are flushed and updated, so the pool has no limit on its
+ * threads, only on the ones left idle */
+#define SEEK_POOL_MAX_UNUSED_THREADS 4
+
+static GThreadPool *seek_pool = NULL;
+
+static void
+seek_pool_func (GnlComposition * comp, gpointer udata)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GstEvent *event;
+
+  g_mutex_lock (&priv->seek_lock);
+  while ((event = priv->pending_seek)) {
+    priv->pending_seek = NULL;
+    g_mutex_unlock (&priv->seek_lock);
+
+    forward_event (comp, GST_OBJECT (comp), prepare_seek (comp, event));
+
+    g_mutex_lock (&priv->seek_lock);
+  }
+  priv->seeking = FALSE;
+  g_mutex_unlock (&priv->seek_lock);
+
+  gst_object_unref (comp);
+}
+
+static GThreadPool *
+get_seek_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    seek_pool = g_thread_pool_new ((GFunc) seek_pool_func, NULL, -1, FALSE,
+        NULL);
+    /* The limit on idle threads is shared by all the pools of the process,
+     * only raise it */
+    if (g_thread_pool_get_max_unused_threads () < SEEK_POOL_MAX_UNUSED_THREADS)
+      g_thread_pool_set_max_unused_threads (SEEK_POOL_MAX_UNUSED_THREADS);
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return seek_pool;
+}
+
+/*
+ * coalesce_seek:
+ *
+ * Leaves @event to the seek pool, replacing the seek it didn't get to yet
+ * for @comp if any. A single pool thread handles the seeks of @comp at a
+ * time, the latest one last.
+ */
+static void
+coalesce_seek (GnlComposition * comp, GstEvent * event)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean queue;
+
+  g_mutex_lock (&priv->seek_lock);
+  if (priv->pending_seek) {
+    GST_DEBUG_OBJECT (comp, "Dropping overtaken seek %" GST_PTR_FORMAT,
+        priv->pending_seek);
+    gst_event_unref (priv->pending_seek);
+    priv->dropped_seeks++;
+  }
+  priv->pending_seek = event;
+  queue = !priv->seeking;
+  priv->seeking = TRUE;
+  g_mutex_unlock (&priv->seek_lock);
+
+  if (queue)
+    g_thread_pool_push (get_seek_pool (), gst_object_ref (comp), NULL);
+}
+
+/* Drops the seek the seek pool didn't get to yet, if any */
+static void
+drop_pending_seek (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  g_mutex_lock (&priv->seek_lock);
+  gst_event_replace (&priv->pending_seek, NULL);
+  g_mutex_unlock (&priv->seek_lock);
+}
+
+static gboolean
+gnl_composition_event_handler (GstPad * ghostpad, GstObject * parent,
+    GstEvent * event)
+{
+  GnlComposition *comp = (GnlComposition *) parent;
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean res = TRUE;
+
+  GST_DEBUG_OBJECT (comp, "event type:%s", GST_EVENT_TYPE_NAME (event));
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEEK:
+    {
+      GstSeekFlags flags;
+      gboolean coalesce;
+
+      gst_event_parse_seek (event, NULL, NULL, &flags, NULL, NULL, NULL,
+          NULL);
+
+      COMP_OBJECTS_LOCK (comp);
+      coalesce = priv->coalesce_seeks;
+      COMP_OBJECTS_UNLOCK (comp);
+
+      if (coalesce && (flags & GST_SEEK_FLAG_FLUSH)) {
+        coalesce_seek (comp, event);
+        goto beach;
+      }
+
+      event = prepare_seek (comp, event);
+      break;
+    }
+    case GST_EVENT_QOS:
+    {
+      gdouble prop;
+      GstQOSType qostype;
+      GstClockTimeDiff diff;
+      GstClockTime timestamp;
+
+      gst_event_parse_qos (event, &qostype, &prop, &diff, &timestamp);
+
+      GST_INFO_OBJECT (comp,
+          "timestamp:%" GST_TIME_FORMAT " segment.start:%" GST_TIME_FORMAT
+          " segment.stop:%" GST_TIME_FORMAT " segment_start%" GST_TIME_FORMAT
           " segment_stop:%" GST_TIME_FORMAT, GST_TIME_ARGS (timestamp),
           GST_TIME_ARGS (priv->outside_segment->start),
           GST_TIME_ARGS (priv->outside_segment->stop),
@@ -1238,24 +2670,8 @@ gnl_composition_event_handler (GstPad * ghostpad, GstObject * parent,
       break;
   }
 
-  if (res && priv->ghostpad) {
-    COMP_OBJECTS_LOCK (comp);
-
-    /* If the timeline isn't entirely reconstructed, we silently ignore the
-     * event. In the case of seeks the pipeline will already be correctly
-     * configured at this point*/
-    if (priv->waitingpads == 0) {
-      COMP_OBJECTS_UNLOCK (comp);
-      GST_DEBUG_OBJECT (comp, "About to call gnl_event_pad_func()");
-      res = priv->gnl_event_pad_func (priv->ghostpad, parent, event);
-      priv->reset_time = FALSE;
-      GST_DEBUG_OBJECT (comp, "Done calling gnl_event_pad_func() %d", res);
-    } else {
-      COMP_OBJECTS_UNLOCK (comp);
-      gst_event_unref (event);
-    }
-
-  }
+  if (res)
+    res = forward_event (comp, parent, event);
 
 beach:
   return res;
@@ -1426,96 +2842,164 @@ refine_start_stop_in_region_above_priority (GnlComposition * composition,
     GstClockTime stop,
     GstClockTime * rstart, GstClockTime * rstop, guint32 priority)
 {
-  GList *tmp;
   GnlObject *object;
   GstClockTime nstart = start, nstop = stop;
+  GstClockTime bound;
 
   GST_DEBUG_OBJECT (composition,
       "timestamp:%" GST_TIME_FORMAT " start: %" GST_TIME_FORMAT " stop: %"
       GST_TIME_FORMAT " priority:%u", GST_TIME_ARGS (timestamp),
       GST_TIME_ARGS (start), GST_TIME_ARGS (stop), priority);
 
-  for (tmp = composition->priv->objects_start; tmp; tmp = tmp->next) {
-    object = (GnlObject *) tmp->data;
-
-    GST_LOG_OBJECT (object, "START %" GST_TIME_FORMAT "--%" GST_TIME_FORMAT,
-        GST_TIME_ARGS (object->start), GST_TIME_ARGS (object->stop));
-
-    if ((object->priority >= priority) || (!object->active))
-      continue;
-
-    if (object->start <= timestamp)
-      continue;
-
-    if (object->start >= nstop)
-      continue;
+  /* Only active objects with a lower priority value can cut the region */
+  if (priority == 0)
+    goto done;
 
-    nstop = object->start;
+  /* First higher-priority object starting after timestamp */
+  bound = gnl_interval_tree_next_start (composition->priv->index, timestamp,
+      priority - 1, TRUE, &object);
+  if (GST_CLOCK_TIME_IS_VALID (bound) && bound < nstop) {
+    nstop = bound;
 
     GST_DEBUG_OBJECT (composition,
         "START Found %s [prio:%u] at %" GST_TIME_FORMAT,
-        GST_OBJECT_NAME (object), object->priority,
-        GST_TIME_ARGS (object->start));
+        GST_OBJECT_NAME (object), object->priority, GST_TIME_ARGS (bound));
+  }
 
-    break;
+  /* Last higher-priority object stopping before timestamp */
+  bound = gnl_interval_tree_prev_stop (composition->priv->index, timestamp,
+      priority - 1, TRUE, &object);
+  if (GST_CLOCK_TIME_IS_VALID (bound) && bound > nstart) {
+    nstart = bound;
+
+    GST_DEBUG_OBJECT (composition,
+        "STOP Found %s [prio:%u] at %" GST_TIME_FORMAT,
+        GST_OBJECT_NAME (object), object->priority, GST_TIME_ARGS (bound));
   }
 
-  for (tmp = composition->priv->objects_stop; tmp; tmp = tmp->next) {
-    object = (GnlObject *) tmp->data;
+done:
+  if (*rstart)
+    *rstart = nstart;
 
-    GST_LOG_OBJECT (object, "STOP %" GST_TIME_FORMAT "--%" GST_TIME_FORMAT,
-        GST_TIME_ARGS (object->start), GST_TIME_ARGS (object->stop));
+  if (*rstop)
+    *rstop = nstop;
+}
 
-    if ((object->priority >= priority) || (!object->active))
-      continue;
 
-    if (object->stop >= timestamp)
-      continue;
+/*
+ * Binary heap of GnlObject ordered by priority, stored in a GPtrArray.
+ */
+static void
+stack_heap_push (GPtrArray * heap, GnlObject * object)
+{
+  guint i, parent;
 
-    if (object->stop <= nstart)
-      continue;
+  g_ptr_array_add (heap, object);
 
-    nstart = object->stop;
+  for (i = heap->len - 1; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+    if (priority_comp (g_ptr_array_index (heap, parent), object) <= 0)
+      break;
+    g_ptr_array_index (heap, i) = g_ptr_array_index (heap, parent);
+  }
 
-    GST_DEBUG_OBJECT (composition,
-        "STOP Found %s [prio:%u] at %" GST_TIME_FORMAT,
-        GST_OBJECT_NAME (object), object->priority,
-        GST_TIME_ARGS (object->start));
+  g_ptr_array_index (heap, i) = object;
+}
 
-    break;
+static GnlObject *
+stack_heap_pop (GPtrArray * heap)
+{
+  GnlObject *top, *last;
+  guint i, child;
+
+  if (!heap->len)
+    return NULL;
+
+  top = g_ptr_array_index (heap, 0);
+  last = g_ptr_array_remove_index (heap, heap->len - 1);
+  if (!heap->len)
+    return top;
+
+  for (i = 0; (child = 2 * i + 1) < heap->len; i = child) {
+    if (child + 1 < heap->len &&
+        priority_comp (g_ptr_array_index (heap, child + 1),
+            g_ptr_array_index (heap, child)) < 0)
+      child++;
+    if (priority_comp (last, g_ptr_array_index (heap, child)) <= 0)
+      break;
+    g_ptr_array_index (heap, i) = g_ptr_array_index (heap, child);
   }
 
-  if (*rstart)
-    *rstart = nstart;
+  g_ptr_array_index (heap, i) = last;
 
-  if (*rstop)
-    *rstop = nstop;
+  return top;
 }
 
+/*
+ * Candidates for a stack, by increasing priority.
+ *
+ * The objects present in the index at the stack timestamp are enumerated
+ * lazily and merged with the expandables, so that convert_list_to_tree()
+ * stops looking at the timeline as soon as the tree is complete.
+ */
+typedef struct
+{
+  GnlIntervalTreeIter *iter;
+  GPtrArray *expandables;
+} StackCandidates;
+
+static inline gboolean
+stack_candidates_empty (StackCandidates * candidates)
+{
+  return !candidates->expandables->len &&
+      !gnl_interval_tree_iter_peek (candidates->iter);
+}
+
+static GnlObject *
+stack_candidates_pop (StackCandidates * candidates)
+{
+  GnlObject *object, *expandable = NULL;
+
+  object = gnl_interval_tree_iter_peek (candidates->iter);
+  if (candidates->expandables->len)
+    expandable = g_ptr_array_index (candidates->expandables, 0);
+
+  if (expandable && (!object || priority_comp (expandable, object) < 0))
+    object = stack_heap_pop (candidates->expandables);
+  else
+    gnl_interval_tree_iter_next (candidates->iter);
+
+  if (object)
+    GST_LOG_OBJECT (object,
+        "start: %" GST_TIME_FORMAT ", stop:%" GST_TIME_FORMAT " , duration:%"
+        GST_TIME_FORMAT ", priority:%u, active:%d",
+        GST_TIME_ARGS (object->start), GST_TIME_ARGS (object->stop),
+        GST_TIME_ARGS (object->duration), object->priority, object->active);
+
+  return object;
+}
 
 /*
- * Converts a sorted list to a tree
+ * Converts the stack candidates to a tree
  * Recursive
  *
- * stack will be set to the next item to use in the parent.
+ * The objects used are popped from the candidates, the others are never
+ * looked at.
  * If operations number of sinks is limited, it will only use that number.
  */
 
 static GNode *
-convert_list_to_tree (GList ** stack, GstClockTime * start,
+convert_list_to_tree (StackCandidates * stack, GstClockTime * start,
     GstClockTime * stop, guint32 * highprio)
 {
   GNode *ret;
   guint nbsinks;
   gboolean limit;
-  GList *tmp;
   GnlObject *object;
 
-  if (!stack || !*stack)
+  if (!stack || !(object = stack_candidates_pop (stack)))
     return NULL;
 
-  object = (GnlObject *) (*stack)->data;
-
   GST_DEBUG ("object:%s , *start:%" GST_TIME_FORMAT ", *stop:%"
       GST_TIME_FORMAT " highprio:%d",
       GST_ELEMENT_NAME (object), GST_TIME_ARGS (*start),
@@ -1537,8 +3021,6 @@ convert_list_to_tree (GList ** stack, GstClockTime * start,
   }
 
   if (GNL_OBJECT_IS_SOURCE (object)) {
-    *stack = g_list_next (*stack);
-
     /* update highest priority.
      * We do this here, since it's only used with sources (leafs of the tree) */
     if (object->priority > *highprio)
@@ -1558,13 +3040,11 @@ convert_list_to_tree (GList ** stack, GstClockTime * start,
     nbsinks = oper->num_sinks;
 
     /* FIXME : if num_sinks == -1 : request the proper number of pads */
-    for (tmp = g_list_next (*stack); tmp && (!limit || nbsinks);) {
-      g_node_append (ret, convert_list_to_tree (&tmp, start, stop, highprio));
+    while (!stack_candidates_empty (stack) && (!limit || nbsinks)) {
+      g_node_append (ret, convert_list_to_tree (stack, start, stop, highprio));
       if (limit)
         nbsinks--;
     }
-
-    *stack = tmp;
   }
 
 beach:
@@ -1581,6 +3061,7 @@ beach:
  * @timestamp: The #GstClockTime to look at
  * @priority: The priority level to start looking from
  * @activeonly: Only look for active elements if TRUE
+ * @reverse: Whether we are looking at the timeline backward
  * @start: The biggest start time of the objects in the stack
  * @stop: The smallest stop time of the objects in the stack
  * @highprio: The highest priority in the stack
@@ -1593,95 +3074,44 @@ beach:
  */
 static GNode *
 get_stack_list (GnlComposition * comp, GstClockTime timestamp,
-    guint32 priority, gboolean activeonly, GstClockTime * start,
-    GstClockTime * stop, guint * highprio)
+    guint32 priority, gboolean activeonly, gboolean reverse,
+    GstClockTime * start, GstClockTime * stop, guint * highprio)
 {
   GList *tmp;
-  GList *stack = NULL;
+  StackCandidates stack;
   GNode *ret = NULL;
   GstClockTime nstart = GST_CLOCK_TIME_NONE;
   GstClockTime nstop = GST_CLOCK_TIME_NONE;
   GstClockTime first_out_of_stack = GST_CLOCK_TIME_NONE;
   guint32 highest = 0;
-  gboolean reverse = (comp->priv->segment->rate < 0.0);
 
   GST_DEBUG_OBJECT (comp,
       "timestamp:%" GST_TIME_FORMAT ", priority:%u, activeonly:%d",
       GST_TIME_ARGS (timestamp), priority, activeonly);
 
-  GST_LOG ("objects_start:%p objects_stop:%p", comp->priv->objects_start,
-      comp->priv->objects_stop);
+  /* Objects present at timestamp, by priority */
+  stack.iter = gnl_interval_tree_iter_new (comp->priv->index, timestamp,
+      priority, activeonly, reverse);
+  stack.expandables = g_ptr_array_new ();
 
-  if (reverse) {
-    for (tmp = comp->priv->objects_stop; tmp; tmp = g_list_next (tmp)) {
-      GnlObject *object = (GnlObject *) tmp->data;
-
-      GST_LOG_OBJECT (object,
-          "start: %" GST_TIME_FORMAT ", stop:%" GST_TIME_FORMAT " , duration:%"
-          GST_TIME_FORMAT ", priority:%u, active:%d",
-          GST_TIME_ARGS (object->start), GST_TIME_ARGS (object->stop),
-          GST_TIME_ARGS (object->duration), object->priority, object->active);
-
-      if (object->stop >= timestamp) {
-        if ((object->start < timestamp) &&
-            (object->priority >= priority) &&
-            ((!activeonly) || (object->active))) {
-          GST_LOG_OBJECT (comp, "adding %s: sorted to the stack",
-              GST_OBJECT_NAME (object));
-          stack = g_list_insert_sorted (stack, object,
-              (GCompareFunc) priority_comp);
-          if (GNL_IS_OPERATION (object))
-            gnl_operation_update_base_time (GNL_OPERATION (object), timestamp);
-        }
-      } else {
-        GST_LOG_OBJECT (comp, "too far, stopping iteration");
-        first_out_of_stack = object->stop;
-        break;
-      }
-    }
-  } else {
-    for (tmp = comp->priv->objects_start; tmp; tmp = g_list_next (tmp)) {
-      GnlObject *object = (GnlObject *) tmp->data;
-
-      GST_LOG_OBJECT (object,
-          "start: %" GST_TIME_FORMAT " , stop:%" GST_TIME_FORMAT " , duration:%"
-          GST_TIME_FORMAT ", priority:%u", GST_TIME_ARGS (object->start),
-          GST_TIME_ARGS (object->stop), GST_TIME_ARGS (object->duration),
-          object->priority);
-
-      if (object->start <= timestamp) {
-        if ((object->stop > timestamp) &&
-            (object->priority >= priority) &&
-            ((!activeonly) || (object->active))) {
-          GST_LOG_OBJECT (comp, "adding %s: sorted to the stack",
-              GST_OBJECT_NAME (object));
-          stack = g_list_insert_sorted (stack, object,
-              (GCompareFunc) priority_comp);
-          if (GNL_IS_OPERATION (object))
-            gnl_operation_update_base_time (GNL_OPERATION (object), timestamp);
-        }
-      } else {
-        GST_LOG_OBJECT (comp, "too far, stopping iteration");
-        first_out_of_stack = object->start;
-        break;
-      }
-    }
-  }
+  /* The stack can't be valid past the next object boundary */
+  if (reverse)
+    first_out_of_stack = gnl_interval_tree_prev_stop (comp->priv->index,
+        timestamp, G_MAXUINT32, FALSE, NULL);
+  else
+    first_out_of_stack = gnl_interval_tree_next_start (comp->priv->index,
+        timestamp, G_MAXUINT32, FALSE, NULL);
 
   /* Insert the expandables */
   if (G_LIKELY (timestamp < GNL_OBJECT_STOP (comp)))
     for (tmp = comp->priv->expandables; tmp; tmp = tmp->next) {
-      GST_DEBUG_OBJECT (comp, "Adding expandable %s sorted to the list",
+      GST_DEBUG_OBJECT (comp, "Adding expandable %s to the heap",
           GST_OBJECT_NAME (tmp->data));
-      stack = g_list_insert_sorted (stack, tmp->data,
-          (GCompareFunc) priority_comp);
-      if (GNL_IS_OPERATION (tmp->data))
-        gnl_operation_update_base_time (GNL_OPERATION (tmp->data), timestamp);
+      stack_heap_push (stack.expandables, tmp->data);
     }
 
-  /* convert that list to a stack */
-  tmp = stack;
-  ret = convert_list_to_tree (&tmp, &nstart, &nstop, &highest);
+  /* convert that heap to a stack */
+  ret = convert_list_to_tree (&stack, &nstart, &nstop, &highest);
   if (GST_CLOCK_TIME_IS_VALID (first_out_of_stack)) {
     if (reverse && nstart < first_out_of_stack)
       nstart = first_out_of_stack;
@@ -1699,17 +3129,445 @@ get_stack_list (GnlComposition * comp, GstClockTime timestamp,
   if (highprio)
     *highprio = highest;
 
-  g_list_free (stack);
+  gnl_interval_tree_iter_free (stack.iter);
+  g_ptr_array_free (stack.expandables, TRUE);
 
   return ret;
 }
 
+/*
+ * resolve_stack:
+ * @comp: The #GnlComposition
+ * @timestamp: The #GstClockTime to look at
+ * @reverse: Whether we are looking at the timeline backward
+ * @start_time: The start of the region over which the stack is valid
+ * @stop_time: The stop of the region over which the stack is valid
+ *
+ * Returns: The stack of active objects at @timestamp, or NULL.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static GNode *
+resolve_stack (GnlComposition * comp, GstClockTime timestamp,
+    gboolean reverse, GstClockTime * start_time, GstClockTime * stop_time)
+{
+  GNode *stack = NULL;
+  GstClockTime start = G_MAXUINT64;
+  GstClockTime stop = G_MAXUINT64;
+  guint highprio;
+
+  stack = get_stack_list (comp, timestamp, 0, TRUE, reverse, &start, &stop,
+      &highprio);
+
+  GST_DEBUG ("start:%" GST_TIME_FORMAT ", stop:%" GST_TIME_FORMAT,
+      GST_TIME_ARGS (start), GST_TIME_ARGS (stop));
+
+  if (stack) {
+    guint32 top_priority = GNL_OBJECT_PRIORITY (stack->data);
+
+    /* Figure out if there's anything blocking us with smaller priority */
+    refine_start_stop_in_region_above_priority (comp, timestamp, start,
+        stop, &start, &stop, (highprio == 0) ? top_priority : highprio);
+  }
+
+  *start_time = start;
+  *stop_time = stop;
+
+  return stack;
+}
+
+/*
+ * Cut list
+ *
+ * The start and stop times of all the objects split the timeline in zones
+ * over which the set of objects present doesn't change. Each zone keeps the
+ * stack resolved for it the first time it is looked up, so that seeks and
+ * EOS only need a binary search to find the next stack.
+ *
+ * When an object changes, only the zones its old and new ranges cover are
+ * reset, along with the neighbouring zones whose stack can reach into those
+ * ranges: a stack going forward never lasts past the next object start, and
+ * going backward never starts before the previous object stop.
+ */
+
+static void
+cut_zone_free (GnlCutZone * zone)
+{
+  if (zone->stack)
+    g_node_destroy (zone->stack);
+  g_slice_free (GnlCutZone, zone);
+}
+
+static void
+cut_zone_reset (GnlCutZone * zone)
+{
+  if (zone->stack)
+    g_node_destroy (zone->stack);
+  zone->stack = NULL;
+  zone->resolved = FALSE;
+}
+
+static gint
+cut_zone_compare (const GnlCutZone * a, const GnlCutZone * b,
+    gpointer udata G_GNUC_UNUSED)
+{
+  if (a->start < b->start)
+    return -1;
+  if (a->start > b->start)
+    return 1;
+  return 0;
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+invalidate_cut_list (GnlComposition * comp)
+{
+  if (comp->priv->cutlist) {
+    GST_LOG_OBJECT (comp, "Dropping cut list");
+    g_sequence_free (comp->priv->cutlist);
+    comp->priv->cutlist = NULL;
+  }
+}
+
+/* Returns: The zone starting at or before @timestamp, or NULL */
+static GSequenceIter *
+cut_list_find (GSequence * cutlist, GstClockTime timestamp)
+{
+  GnlCutZone key;
+  GSequenceIter *iter;
+
+  key.start = timestamp;
+  iter = g_sequence_search (cutlist, &key, (GCompareDataFunc) cut_zone_compare,
+      NULL);
+
+  if (g_sequence_iter_is_begin (iter))
+    return NULL;
+
+  return g_sequence_iter_prev (iter);
+}
+
+static void
+cut_list_add_boundary (GSequence * cutlist, GstClockTime timestamp,
+    gboolean start)
+{
+  GnlCutZone key, *zone;
+  GSequenceIter *iter;
+
+  key.start = timestamp;
+  iter = g_sequence_lookup (cutlist, &key, (GCompareDataFunc) cut_zone_compare,
+      NULL);
+
+  if (iter) {
+    zone = g_sequence_get (iter);
+  } else {
+    zone = g_slice_new0 (GnlCutZone);
+    zone->start = timestamp;
+    g_sequence_insert_sorted (cutlist, zone,
+        (GCompareDataFunc) cut_zone_compare, NULL);
+  }
+
+  if (start)
+    zone->starts++;
+  else
+    zone->stops++;
+}
+
+static void
+cut_list_remove_boundary (GSequence * cutlist, GstClockTime timestamp,
+    gboolean start)
+{
+  GnlCutZone key, *zone;
+  GSequenceIter *iter;
+
+  key.start = timestamp;
+  iter = g_sequence_lookup (cutlist, &key, (GCompareDataFunc) cut_zone_compare,
+      NULL);
+  if (G_UNLIKELY (!iter))
+    return;
+
+  zone = g_sequence_get (iter);
+  if (start && zone->starts)
+    zone->starts--;
+  else if (!start && zone->stops)
+    zone->stops--;
+
+  if (!zone->starts && !zone->stops)
+    g_sequence_remove (iter);
+}
+
+/*
+ * cut_list_invalidate:
+ *
+ * Resets the zones whose stack can change when something changes between
+ * @start and @stop.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+cut_list_invalidate (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop)
+{
+  GSequence *cutlist = comp->priv->cutlist;
+  GSequenceIter *iter, *first;
+  GnlCutZone *zone;
+
+  if (!cutlist)
+    return;
+
+  GST_LOG_OBJECT (comp, "Invalidating cut list from %" GST_TIME_FORMAT
+      " to %" GST_TIME_FORMAT, GST_TIME_ARGS (start), GST_TIME_ARGS (stop));
+
+  first = cut_list_find (cutlist, start);
+  iter = first ? first : g_sequence_get_begin_iter (cutlist);
+
+  /* The zones overlapping the range */
+  for (; !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    zone = g_sequence_get (iter);
+    if (zone->start > stop)
+      break;
+    cut_zone_reset (zone);
+  }
+
+  /* The following ones until an object stops */
+  for (; !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    zone = g_sequence_get (iter);
+    if (zone->stops)
+      break;
+    cut_zone_reset (zone);
+  }
+
+  /* The previous ones until an object starts */
+  for (iter = first; iter && !g_sequence_iter_is_begin (iter);) {
+    zone = g_sequence_get (iter);
+    if (zone->starts)
+      break;
+    iter = g_sequence_iter_prev (iter);
+    cut_zone_reset (g_sequence_get (iter));
+  }
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+cut_list_add_object (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop)
+{
+  if (!comp->priv->cutlist)
+    return;
+
+  /* The zones to reset are found before the new boundaries can hide them */
+  cut_list_invalidate (comp, start, stop);
+  cut_list_add_boundary (comp->priv->cutlist, start, TRUE);
+  cut_list_add_boundary (comp->priv->cutlist, stop, FALSE);
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+cut_list_remove_object (GnlComposition * comp, GstClockTime start,
+    GstClockTime stop)
+{
+  if (!comp->priv->cutlist)
+    return;
+
+  cut_list_remove_boundary (comp->priv->cutlist, start, TRUE);
+  cut_list_remove_boundary (comp->priv->cutlist, stop, FALSE);
+  cut_list_invalidate (comp, start, stop);
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+cut_list_move_object (GnlComposition * comp, GstClockTime oldstart,
+    GstClockTime oldstop, GstClockTime start, GstClockTime stop)
+{
+  if (!comp->priv->cutlist)
+    return;
+
+  cut_list_remove_object (comp, oldstart, oldstop);
+  cut_list_add_object (comp, start, stop);
+}
+
+/*
+ * cut_list_sync_stop:
+ *
+ * Moves the end of the expandables to the current composition stop.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+cut_list_sync_stop (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GstClockTime compstop = GNL_OBJECT_STOP (comp);
+
+  if (!priv->cutlist || !priv->expandables || priv->cutlist_stop == compstop)
+    return;
+
+  cut_list_remove_boundary (priv->cutlist, priv->cutlist_stop, FALSE);
+  cut_list_invalidate (comp, MIN (priv->cutlist_stop, compstop),
+      MAX (priv->cutlist_stop, compstop));
+  cut_list_add_boundary (priv->cutlist, compstop, FALSE);
+  priv->cutlist_stop = compstop;
+}
+
+static void
+add_object_boundaries (GnlObject * object, GSequence * cutlist)
+{
+  cut_list_add_boundary (cutlist, object->start, TRUE);
+  cut_list_add_boundary (cutlist, object->stop, FALSE);
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+ensure_cut_list (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  if (priv->cutlist) {
+    cut_list_sync_stop (comp);
+    return;
+  }
+
+  priv->cutlist = g_sequence_new ((GDestroyNotify) cut_zone_free);
+  gnl_interval_tree_foreach (priv->index, (GFunc) add_object_boundaries,
+      priv->cutlist);
+
+  priv->cutlist_stop = GNL_OBJECT_STOP (comp);
+  if (priv->expandables) {
+    cut_list_add_boundary (priv->cutlist, 0, TRUE);
+    cut_list_add_boundary (priv->cutlist, priv->cutlist_stop, FALSE);
+  }
+
+  GST_DEBUG_OBJECT (comp, "Built cut list with %d boundaries",
+      g_sequence_get_length (priv->cutlist));
+}
+
+/*
+ * cut_list_resolve:
+ *
+ * Returns: The zone at @iter, with its stack resolved, or NULL if @iter is
+ * the end of the last zone.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static GnlCutZone *
+cut_list_resolve (GnlComposition * comp, GSequenceIter * iter)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GstClockTime compstop = GNL_OBJECT_STOP (comp);
+  GstClockTime ignored, stop, revts;
+  GSequenceIter *next;
+  GnlCutZone *zone;
+  GNode *revstack;
+
+  next = g_sequence_iter_next (iter);
+  if (g_sequence_iter_is_end (next))
+    return NULL;
+
+  zone = g_sequence_get (iter);
+  if (zone->resolved)
+    return zone;
+
+  stop = ((GnlCutZone *) g_sequence_get (next))->start;
+
+  zone->stack = resolve_stack (comp, zone->start, FALSE, &ignored,
+      &zone->stack_stop);
+  zone->fingerprint = stack_fingerprint (zone->stack);
+
+  /* Going backward, the zone is ]start, stop], except that the
+   * expandables aren't used at the composition stop */
+  revts = stop;
+  if (priv->expandables && revts >= compstop)
+    revts--;
+
+  if (revts > zone->start) {
+    revstack = resolve_stack (comp, revts, TRUE, &zone->stack_start, &ignored);
+    if (revstack)
+      g_node_destroy (revstack);
+  } else
+    zone->stack_start = GST_CLOCK_TIME_NONE;
+
+  zone->resolved = TRUE;
+
+  return zone;
+}
+
+/*
+ * lookup_cut_list:
+ *
+ * Returns: The zone of the cut list containing @timestamp, or NULL if the
+ * cut list isn't built or doesn't know the stack at @timestamp.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static GnlCutZone *
+lookup_cut_list (GnlComposition * comp, GstClockTime timestamp,
+    gboolean reverse)
+{
+  GSequence *cutlist = comp->priv->cutlist;
+  GSequenceIter *iter;
+  GnlCutZone *zone;
+
+  if (!cutlist)
+    return NULL;
+
+  cut_list_sync_stop (comp);
+
+  if (reverse && comp->priv->expandables &&
+      timestamp >= GNL_OBJECT_STOP (comp))
+    return NULL;
+
+  /* Going backward, the zone is the one with start < timestamp <= stop */
+  if (reverse) {
+    if (timestamp == 0)
+      return NULL;
+    iter = cut_list_find (cutlist, timestamp - 1);
+  } else
+    iter = cut_list_find (cutlist, timestamp);
+
+  if (!iter || !(zone = cut_list_resolve (comp, iter)))
+    return NULL;
+
+  if (reverse && !GST_CLOCK_TIME_IS_VALID (zone->stack_start))
+    return NULL;
+
+  return zone;
+}
+
+static GArray *
+gnl_composition_get_cut_list (GnlComposition * comp)
+{
+  GArray *points = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  GnlCutZone *zone, *prev = NULL;
+  GSequenceIter *iter;
+
+  COMP_OBJECTS_LOCK (comp);
+  ensure_cut_list (comp);
+
+  for (iter = g_sequence_get_begin_iter (comp->priv->cutlist);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    if (!(zone = cut_list_resolve (comp, iter))) {
+      /* End of the last zone */
+      zone = g_sequence_get (iter);
+      if (prev)
+        g_array_append_val (points, zone->start);
+      break;
+    }
+
+    if (!prev || prev->fingerprint != zone->fingerprint)
+      g_array_append_val (points, zone->start);
+    prev = zone;
+  }
+  COMP_OBJECTS_UNLOCK (comp);
+
+  return points;
+}
+
 /*
  * get_clean_toplevel_stack:
  * @comp: The #GnlComposition
  * @timestamp: The #GstClockTime to look at
  * @stop_time: Pointer to a #GstClockTime for min stop time of returned stack
  * @start_time: Pointer to a #GstClockTime for greatest start time of returned stack
+ * @fingerprint: Set to the stack_fingerprint() of the returned stack
  *
  * Returns: The new current stack for the given #GnlComposition and @timestamp.
  *
@@ -1717,20 +3575,30 @@ get_stack_list (GnlComposition * comp, GstClockTime timestamp,
  */
 static GNode *
 get_clean_toplevel_stack (GnlComposition * comp, GstClockTime * timestamp,
-    GstClockTime * start_time, GstClockTime * stop_time)
+    GstClockTime * start_time, GstClockTime * stop_time, guint64 * fingerprint)
 {
   GNode *stack = NULL;
   GstClockTime start = G_MAXUINT64;
   GstClockTime stop = G_MAXUINT64;
-  guint highprio;
+  GnlCutZone *zone;
   gboolean reverse = (comp->priv->segment->rate < 0.0);
 
   GST_DEBUG_OBJECT (comp, "timestamp:%" GST_TIME_FORMAT,
       GST_TIME_ARGS (*timestamp));
-  GST_DEBUG ("start:%" GST_TIME_FORMAT ", stop:%" GST_TIME_FORMAT,
-      GST_TIME_ARGS (start), GST_TIME_ARGS (stop));
 
-  stack = get_stack_list (comp, *timestamp, 0, TRUE, &start, &stop, &highprio);
+  if ((zone = lookup_cut_list (comp, *timestamp, reverse))) {
+    GST_DEBUG_OBJECT (comp, "Using cut list zone at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (zone->start));
+
+    if (zone->stack)
+      stack = g_node_copy (zone->stack);
+    start = zone->stack_start;
+    stop = zone->stack_stop;
+    *fingerprint = zone->fingerprint;
+  } else {
+    stack = resolve_stack (comp, *timestamp, reverse, &start, &stop);
+    *fingerprint = stack_fingerprint (stack);
+  }
 
   if (!stack &&
       ((reverse && (*timestamp > COMP_REAL_START (comp))) ||
@@ -1748,13 +3616,10 @@ get_clean_toplevel_stack (GnlComposition * comp, GstClockTime * timestamp,
   GST_DEBUG ("start:%" GST_TIME_FORMAT ", stop:%" GST_TIME_FORMAT,
       GST_TIME_ARGS (start), GST_TIME_ARGS (stop));
 
-  if (stack) {
-    guint32 top_priority = GNL_OBJECT_PRIORITY (stack->data);
-
-    /* Figure out if there's anything blocking us with smaller priority */
-    refine_start_stop_in_region_above_priority (comp, *timestamp, start,
-        stop, &start, &stop, (highprio == 0) ? top_priority : highprio);
-  }
+  /* Operations need the new position to compute their base time */
+  if (stack)
+    g_node_traverse (stack, G_IN_ORDER, G_TRAVERSE_ALL, -1,
+        (GNodeTraverseFunc) update_base_time, timestamp);
 
   if (*stop_time) {
     if (stack)
@@ -1836,60 +3701,157 @@ set_child_caps (GValue * item, GValue * ret G_GNUC_UNUSED, GnlObject * comp)
   return TRUE;
 }
 
+/* Moves on to the stack following the one that just ended */
+static void
+update_pipeline_step (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean reverse = (priv->segment->rate < 0.0);
+  gboolean gapless;
+
+  /* Set up a non-initial seek on segment_stop */
+  if (!reverse) {
+    GST_DEBUG_OBJECT (comp,
+        "Setting segment->start to segment_stop:%" GST_TIME_FORMAT,
+        GST_TIME_ARGS (priv->segment_stop));
+    priv->segment->start = priv->segment_stop;
+  } else {
+    GST_DEBUG_OBJECT (comp,
+        "Setting segment->stop to segment_start:%" GST_TIME_FORMAT,
+        GST_TIME_ARGS (priv->segment_start));
+    priv->segment->stop = priv->segment_start;
+  }
+
+  /* Unless the switch is gapless, downstream is flushed before the next
+   * stack starts */
+  COMP_OBJECTS_LOCK (comp);
+  gapless = priv->gapless;
+  COMP_OBJECTS_UNLOCK (comp);
+
+  if (!gapless && priv->ghostpad) {
+    GST_DEBUG_OBJECT (comp, "Flushing downstream before switching stacks");
+    gst_pad_push_event (priv->ghostpad, gst_event_new_flush_start ());
+    gst_pad_push_event (priv->ghostpad, gst_event_new_flush_stop (FALSE));
+  }
+
+  seek_handling (comp, TRUE, TRUE);
+
+  if (!priv->current) {
+    /* If we're at the end, post SEGMENT_DONE, or push EOS */
+    GST_DEBUG_OBJECT (comp, "Nothing else to play");
+
+    if (!(priv->segment->flags & GST_SEEK_FLAG_SEGMENT)
+        && priv->ghostpad) {
+      GST_DEBUG_OBJECT (comp, "Real EOS should be sent now");
+    } else if (priv->segment->flags & GST_SEEK_FLAG_SEGMENT) {
+      gint64 epos;
+
+      if (GST_CLOCK_TIME_IS_VALID (priv->segment->stop))
+        epos = (MIN (priv->segment->stop, GNL_OBJECT_STOP (comp)));
+      else
+        epos = GNL_OBJECT_STOP (comp);
+
+      GST_LOG_OBJECT (comp, "Emitting segment done pos %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (epos));
+      gst_element_post_message (GST_ELEMENT_CAST (comp),
+          gst_message_new_segment_done (GST_OBJECT (comp),
+              priv->segment->format, epos));
+      gst_pad_push_event (priv->ghostpad,
+          gst_event_new_segment_done (priv->segment->format, epos));
+    }
+  }
+}
+
 static gpointer
 update_pipeline_func (GnlComposition * comp)
 {
   while (comp->priv->running) {
-    GnlCompositionPrivate *priv;
-    gboolean reverse;
+    WAIT_FOR_UPDATE_PIPELINE (comp);
+
+    /* Woken up to stop */
+    if (g_atomic_int_get (&comp->priv->running))
+      update_pipeline_step (comp);
+  }
+
+  return NULL;
+}
+
+/*
+ * Shared scheduler
+ *
+ * Compositions using the shared scheduler queue themselves in a process-wide
+ * pool when they need a pipeline update. A composition is only queued when
+ * it has no update pending already, and the worker handling it does all its
+ * pending updates in turn, which keeps them ordered.
+ */
+static GThreadPool *scheduler_pool = NULL;
+
+static void
+shared_update_pipeline_func (GnlComposition * comp, gpointer udata)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  /* The requests made while going to NULL are dropped */
+  do {
+    if (g_atomic_int_get (&priv->running))
+      update_pipeline_step (comp);
+    else
+      GST_DEBUG_OBJECT (comp, "Not running anymore, dropping update");
+  } while (!g_atomic_int_dec_and_test (&priv->pending_updates));
+
+  g_mutex_lock (&priv->update_pipeline_mutex);
+  g_cond_broadcast (&priv->update_pipeline_cond);
+  g_mutex_unlock (&priv->update_pipeline_mutex);
+
+  gst_object_unref (comp);
+}
+
+static GThreadPool *
+get_scheduler_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    scheduler_pool =
+        g_thread_pool_new ((GFunc) shared_update_pipeline_func, NULL,
+        g_get_num_processors (), FALSE, NULL);
+    g_once_init_leave (&initialized, 1);
+  }
 
-    WAIT_FOR_UPDATE_PIPELINE (comp);
+  return scheduler_pool;
+}
 
-    /* Set up a non-initial seek on segment_stop */
-    priv = comp->priv;
-    reverse = (priv->segment->rate < 0.0);
-    if (!reverse) {
-      GST_DEBUG_OBJECT (comp,
-          "Setting segment->start to segment_stop:%" GST_TIME_FORMAT,
-          GST_TIME_ARGS (priv->segment_stop));
-      priv->segment->start = priv->segment_stop;
-    } else {
-      GST_DEBUG_OBJECT (comp,
-          "Setting segment->stop to segment_start:%" GST_TIME_FORMAT,
-          GST_TIME_ARGS (priv->segment_start));
-      priv->segment->stop = priv->segment_start;
-    }
+static void
+request_update_pipeline (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
 
-    seek_handling (comp, TRUE, TRUE);
+  if (!priv->use_shared_scheduler) {
+    SIGNAL_UPDATE_PIPELINE (comp);
+    return;
+  }
 
-    if (!priv->current) {
-      /* If we're at the end, post SEGMENT_DONE, or push EOS */
-      GST_DEBUG_OBJECT (comp, "Nothing else to play");
+  if (!g_atomic_int_get (&priv->running)) {
+    GST_DEBUG_OBJECT (comp, "Not running, not scheduling an update");
+    return;
+  }
 
-      if (!(priv->segment->flags & GST_SEEK_FLAG_SEGMENT)
-          && priv->ghostpad) {
-        GST_DEBUG_OBJECT (comp, "Real EOS should be sent now");
-      } else if (priv->segment->flags & GST_SEEK_FLAG_SEGMENT) {
-        gint64 epos;
+  GST_INFO_OBJECT (comp, "scheduling update from thread %p", g_thread_self ());
 
-        if (GST_CLOCK_TIME_IS_VALID (priv->segment->stop))
-          epos = (MIN (priv->segment->stop, GNL_OBJECT_STOP (comp)));
-        else
-          epos = GNL_OBJECT_STOP (comp);
-
-        GST_LOG_OBJECT (comp, "Emitting segment done pos %" GST_TIME_FORMAT,
-            GST_TIME_ARGS (epos));
-        gst_element_post_message (GST_ELEMENT_CAST (comp),
-            gst_message_new_segment_done (GST_OBJECT (comp),
-                priv->segment->format, epos));
-        gst_pad_push_event (priv->ghostpad,
-            gst_event_new_segment_done (priv->segment->format, epos));
-      }
-    }
+  if (g_atomic_int_add (&priv->pending_updates, 1) == 0)
+    g_thread_pool_push (get_scheduler_pool (), gst_object_ref (comp), NULL);
+}
 
-  }
+/* Waits for the updates in progress in the shared scheduler */
+static void
+wait_shared_updates (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
 
-  return NULL;
+  g_mutex_lock (&priv->update_pipeline_mutex);
+  while (g_atomic_int_get (&priv->pending_updates) > 0)
+    g_cond_wait (&priv->update_pipeline_cond, &priv->update_pipeline_mutex);
+  g_mutex_unlock (&priv->update_pipeline_mutex);
 }
 
 static GstStateChangeReturn
@@ -1904,10 +3866,12 @@ gnl_composition_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
-      comp->priv->running = TRUE;
-      comp->priv->update_pipeline_thread =
-          g_thread_new ("update_pipeline_thread",
-          (GThreadFunc) update_pipeline_func, comp);
+      g_atomic_int_set (&comp->priv->running, TRUE);
+      comp->priv->use_shared_scheduler = comp->priv->shared_scheduler;
+      if (!comp->priv->use_shared_scheduler)
+        comp->priv->update_pipeline_thread =
+            g_thread_new ("update_pipeline_thread",
+            (GThreadFunc) update_pipeline_func, comp);
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
     {
@@ -1957,14 +3921,26 @@ gnl_composition_change_state (GstElement * element, GstStateChange transition)
       COMP_OBJECTS_UNLOCK (comp);
     }
       break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      /* Playing on from the keyframe, going back to refine would jump */
+      cancel_refine (comp);
+      break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* The seek being handled, if any, is done on the reset composition */
+      drop_pending_seek (comp);
       gnl_composition_reset (comp);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
+      /* Stop taking update requests before resetting, and let the updates
+       * in progress finish */
+      g_atomic_int_set (&comp->priv->running, FALSE);
+      if (comp->priv->use_shared_scheduler) {
+        wait_shared_updates (comp);
+      } else {
+        SIGNAL_UPDATE_PIPELINE (comp);
+        g_thread_join (comp->priv->update_pipeline_thread);
+      }
       gnl_composition_reset (comp);
-      comp->priv->running = FALSE;
-      SIGNAL_UPDATE_PIPELINE (comp);
-      g_thread_join (comp->priv->update_pipeline_thread);
       break;
     default:
       break;
@@ -1988,40 +3964,6 @@ beach:
   return ret;
 }
 
-static gint
-objects_start_compare (GnlObject * a, GnlObject * b)
-{
-  if (a->start == b->start) {
-    if (a->priority < b->priority)
-      return -1;
-    if (a->priority > b->priority)
-      return 1;
-    return 0;
-  }
-  if (a->start < b->start)
-    return -1;
-  if (a->start > b->start)
-    return 1;
-  return 0;
-}
-
-static gint
-objects_stop_compare (GnlObject * a, GnlObject * b)
-{
-  if (a->stop == b->stop) {
-    if (a->priority < b->priority)
-      return -1;
-    if (a->priority > b->priority)
-      return 1;
-    return 0;
-  }
-  if (b->stop < a->stop)
-    return -1;
-  if (b->stop > a->stop)
-    return 1;
-  return 0;
-}
-
 /* WITH OBJECTS LOCK TAKEN */
 static void
 update_start_stop_duration (GnlComposition * comp)
@@ -2030,7 +3972,7 @@ update_start_stop_duration (GnlComposition * comp)
   GnlObject *cobj = (GnlObject *) comp;
   GnlCompositionPrivate *priv = comp->priv;
 
-  if (!priv->objects_start) {
+  if (!gnl_interval_tree_size (priv->index)) {
     GST_LOG ("no objects, resetting everything to 0");
 
     if (cobj->start) {
@@ -2069,7 +4011,7 @@ update_start_stop_duration (GnlComposition * comp)
   } else {
 
     /* Else it's the first object's start value */
-    obj = (GnlObject *) priv->objects_start->data;
+    obj = gnl_interval_tree_get_first (priv->index);
 
     if (obj->start != cobj->start) {
       GST_LOG_OBJECT (obj, "setting start from %s to %" GST_TIME_FORMAT,
@@ -2081,7 +4023,7 @@ update_start_stop_duration (GnlComposition * comp)
 
   }
 
-  obj = (GnlObject *) priv->objects_stop->data;
+  obj = gnl_interval_tree_get_last (priv->index);
 
   if (obj->stop != cobj->stop) {
     GST_LOG_OBJECT (obj, "setting stop from %s to %" GST_TIME_FORMAT,
@@ -2126,6 +4068,8 @@ no_more_pads_object_cb (GstElement * element, GnlComposition * comp)
   GNode *tmp;
   GstPad *pad = NULL;
   GnlCompositionEntry *entry;
+  GnlTimelineSnapshot *snapshot;
+  gboolean in_stack;
 
   GST_LOG_OBJECT (comp, "no more pads on element %s",
       GST_ELEMENT_NAME (element));
@@ -2133,6 +4077,17 @@ no_more_pads_object_cb (GstElement * element, GnlComposition * comp)
   if (!(pad = get_src_pad (element)))
     goto no_source;
 
+  /* No need to wait for the objects lock for objects that aren't used */
+  snapshot = get_snapshot (comp);
+  in_stack = !snapshot->stable || (snapshot->stack &&
+      g_node_find (snapshot->stack, G_IN_ORDER, G_TRAVERSE_ALL, object));
+  timeline_snapshot_unref (snapshot);
+
+  if (!in_stack) {
+    gst_object_unref (pad);
+    goto not_in_snapshot;
+  }
+
   COMP_OBJECTS_LOCK (comp);
 
   if (G_UNLIKELY (priv->current == NULL)) {
@@ -2254,6 +4209,14 @@ not_in_stack:
         GST_ELEMENT_NAME (object));
     goto done;
   }
+
+not_in_snapshot:
+  {
+    GST_LOG_OBJECT (comp,
+        "The following object is not in the published stack : %s",
+        GST_ELEMENT_NAME (object));
+    return;
+  }
 }
 
 /*
@@ -2595,48 +4558,457 @@ unlock_activate_stack (GnlComposition * comp, GNode * node, GstState state)
     unlock_activate_stack (comp, child, state);
 }
 
+/*
+ * Parallel activation
+ *
+ * The objects of the stack are put in a queue shared by the thread
+ * activating the stack and some threads of a process-wide pool, which all
+ * set them to the target state until the queue is empty. The activating
+ * thread takes part so that the activation of nested compositions can't
+ * starve, whatever the pool is busy with.
+ */
+typedef struct
+{
+  gint refcount;
+
+  GMutex lock;
+  GCond cond;
+  GQueue pending;               /* Objects still to activate */
+  guint running;                /* Number of objects being activated */
+  GstState state;
+} GnlActivation;
+
+static GThreadPool *activation_pool = NULL;
+
+static void
+activation_unref (GnlActivation * activation)
+{
+  if (g_atomic_int_dec_and_test (&activation->refcount)) {
+    g_mutex_clear (&activation->lock);
+    g_cond_clear (&activation->cond);
+    g_slice_free (GnlActivation, activation);
+  }
+}
+
+static void
+activation_run (GnlActivation * activation)
+{
+  GstElement *element;
+
+  g_mutex_lock (&activation->lock);
+  while ((element = g_queue_pop_head (&activation->pending))) {
+    activation->running++;
+    g_mutex_unlock (&activation->lock);
+
+    gst_element_set_state (element, activation->state);
+
+    g_mutex_lock (&activation->lock);
+    activation->running--;
+    g_cond_broadcast (&activation->cond);
+  }
+  g_mutex_unlock (&activation->lock);
+}
+
+static void
+activation_pool_func (GnlActivation * activation, gpointer udata)
+{
+  activation_run (activation);
+  activation_unref (activation);
+}
+
+static GThreadPool *
+get_activation_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    activation_pool =
+        g_thread_pool_new ((GFunc) activation_pool_func, NULL,
+        g_get_num_processors (), FALSE, NULL);
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return activation_pool;
+}
+
 static gboolean
-are_same_stacks (GNode * stack1, GNode * stack2)
+unlock_queue_node (GNode * node, GnlActivation * activation)
 {
-  gboolean res = FALSE;
+  gst_element_set_locked_state ((GstElement *) (node->data), FALSE);
+  g_queue_push_tail (&activation->pending, node->data);
 
-  /* TODO : FIXME : we should also compare start/inpoint */
-  /* stacks are not equal if one of them is NULL but not the other */
-  if ((!stack1 && stack2) || (stack1 && !stack2))
-    goto beach;
+  return FALSE;
+}
+
+/* Same as unlock_activate_stack(), activating the objects concurrently */
+static void
+unlock_activate_stack_parallel (GnlComposition * comp, GNode * node,
+    GstState state)
+{
+  GnlActivation *activation = g_slice_new0 (GnlActivation);
+  GThreadPool *pool = get_activation_pool ();
+  guint i, helpers;
 
-  if (stack1 && stack2) {
-    GNode *child1, *child2;
+  activation->refcount = 1;
+  g_mutex_init (&activation->lock);
+  g_cond_init (&activation->cond);
+  activation->state = state;
 
-    /* if they don't contain the same source, not equal */
-    if (!(stack1->data == stack2->data))
-      goto beach;
+  g_node_traverse (node, G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+      (GNodeTraverseFunc) unlock_queue_node, activation);
 
-    /* if they don't have the same number of children, not equal */
-    if (!(g_node_n_children (stack1) == g_node_n_children (stack2)))
-      goto beach;
+  helpers = MIN (activation->pending.length - 1,
+      (guint) g_thread_pool_get_max_threads (pool));
 
-    child1 = stack1->children;
-    child2 = stack2->children;
-    while (child1 && child2) {
-      if (!(are_same_stacks (child1, child2)))
-        goto beach;
-      child1 = g_node_next_sibling (child1);
-      child2 = g_node_next_sibling (child2);
-    }
+  GST_DEBUG_OBJECT (comp, "Activating %u objects with %u helper threads",
+      activation->pending.length, helpers);
 
-    /* if there's a difference in child number, stacks are not equal */
-    if (child1 || child2)
-      goto beach;
+  for (i = 0; i < helpers; i++) {
+    g_atomic_int_inc (&activation->refcount);
+    g_thread_pool_push (pool, activation, NULL);
   }
 
-  /* if stack1 AND stack2 are NULL, then they're equal (both empty) */
-  res = TRUE;
+  activation_run (activation);
 
-beach:
-  GST_LOG ("Stacks are equal : %d", res);
+  /* Wait for the objects the helpers are still activating */
+  g_mutex_lock (&activation->lock);
+  while (activation->running)
+    g_cond_wait (&activation->cond, &activation->lock);
+  g_mutex_unlock (&activation->lock);
 
-  return res;
+  activation_unref (activation);
+}
+
+static inline guint64
+fingerprint_mix (guint64 hash, guint64 value)
+{
+  /* splitmix64 finalizer on the value, then FNV-1a style combination so
+   * that the result depends on the order of the values */
+  value += G_GUINT64_CONSTANT (0x9e3779b97f4a7c15);
+  value = (value ^ (value >> 30)) * G_GUINT64_CONSTANT (0xbf58476d1ce4e5b9);
+  value = (value ^ (value >> 27)) * G_GUINT64_CONSTANT (0x94d049bb133111eb);
+  value ^= value >> 31;
+
+  return (hash ^ value) * G_GUINT64_CONSTANT (0x100000001b3);
+}
+
+/*
+ * stack_fingerprint:
+ *
+ * Returns: A 64 bit hash of @stack, covering the identity, start and inpoint
+ * of each object and the shape of the tree. Stacks with the same fingerprint
+ * are considered equal, the empty stack has fingerprint 0.
+ */
+static guint64
+stack_fingerprint (GNode * stack)
+{
+  GnlObject *object;
+  GNode *child;
+  guint64 hash;
+
+  if (!stack)
+    return 0;
+
+  object = (GnlObject *) stack->data;
+
+  hash = fingerprint_mix (G_GUINT64_CONSTANT (0xcbf29ce484222325),
+      (guint64) GPOINTER_TO_SIZE (object));
+  hash = fingerprint_mix (hash, object->start);
+  hash = fingerprint_mix (hash, object->inpoint);
+  hash = fingerprint_mix (hash, g_node_n_children (stack));
+
+  for (child = stack->children; child; child = child->next)
+    hash = fingerprint_mix (hash, stack_fingerprint (child));
+
+  return hash;
+}
+
+/*
+ * Paused cache
+ *
+ * Objects that stop being used go to the head of the paused cache and stay
+ * in GST_STATE_PAUSED, so that going back to them doesn't need to set them
+ * up again. Once the cache is full, the least recently used ones are set to
+ * the deactivated-elements-state.
+ */
+
+static guint
+paused_cache_capacity (GnlCompositionPrivate * priv)
+{
+  guint64 capacity = priv->paused_cache_size;
+
+  if (priv->paused_cache_max_bytes && priv->paused_cache_object_size)
+    capacity = MIN (capacity,
+        priv->paused_cache_max_bytes / priv->paused_cache_object_size);
+
+  return (guint) capacity;
+}
+
+/* WITH OBJECTS LOCK TAKEN */
+static void
+trim_paused_cache (GnlComposition * comp)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  guint capacity = paused_cache_capacity (priv);
+  GstElement *element;
+
+  while (priv->paused_cache.length > capacity) {
+    element = g_queue_pop_tail (&priv->paused_cache);
+
+    GST_DEBUG_OBJECT (comp, "Evicting %s from the paused cache",
+        GST_ELEMENT_NAME (element));
+    gst_element_set_state (element, priv->deactivated_elements_state);
+  }
+}
+
+/*
+ * deactivate_element:
+ *
+ * Sets @element, which isn't used anymore, to the deactivated state or
+ * keeps it in PAUSED at the head of the paused cache. trim_paused_cache()
+ * must be called once done deactivating elements.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+deactivate_element (GnlComposition * comp, GstElement * element)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  /* Elements being removed don't have an entry anymore */
+  if (!paused_cache_capacity (priv) || !COMP_ENTRY (comp, element)) {
+    gst_element_set_state (element, priv->deactivated_elements_state);
+    return;
+  }
+
+  GST_LOG_OBJECT (comp, "Keeping %s in the paused cache",
+      GST_ELEMENT_NAME (element));
+
+  g_queue_remove (&priv->paused_cache, element);
+  g_queue_push_head (&priv->paused_cache, element);
+  gst_element_set_state (element, GST_STATE_PAUSED);
+}
+
+static gboolean
+uncache_node (GNode * node, GnlComposition * comp)
+{
+  g_queue_remove (&comp->priv->paused_cache, node->data);
+
+  return FALSE;
+}
+
+#define PREFETCH_ZONES(priv) \
+  (MAX ((priv)->prefetch_zones, (priv)->lookahead ? 1 : 0))
+
+/* TRUE if @seek1 and @seek2 seek to the same segment */
+static gboolean
+same_seek (GstEvent * seek1, GstEvent * seek2)
+{
+  gdouble rate1, rate2;
+  GstFormat format1, format2;
+  GstSeekFlags flags1, flags2;
+  GstSeekType starttype1, starttype2, stoptype1, stoptype2;
+  gint64 start1, start2, stop1, stop2;
+
+  gst_event_parse_seek (seek1, &rate1, &format1, &flags1, &starttype1, &start1,
+      &stoptype1, &stop1);
+  gst_event_parse_seek (seek2, &rate2, &format2, &flags2, &starttype2, &start2,
+      &stoptype2, &stop2);
+
+  return rate1 == rate2 && format1 == format2 && flags1 == flags2 &&
+      starttype1 == starttype2 && start1 == start2 &&
+      stoptype1 == stoptype2 && stop1 == stop2;
+}
+
+typedef struct
+{
+  GnlComposition *comp;
+  GstEvent *seek;               /* Seek for the zone being prerolled */
+} GnlPrerollData;
+
+static gboolean
+preroll_node (GNode * node, GnlPrerollData * data)
+{
+  GstElement *element = (GstElement *) node->data;
+  GnlComposition *comp = data->comp;
+  GnlCompositionPrivate *priv = comp->priv;
+  GnlCompositionEntry *entry = COMP_ENTRY (comp, element);
+
+  /* Already being played, or already prerolled */
+  if ((priv->current &&
+          g_node_find (priv->current, G_IN_ORDER, G_TRAVERSE_ALL, element)) ||
+      entry->prerolled)
+    return FALSE;
+
+  /* Out of budget, the remaining objects are farther from the playhead */
+  if (priv->n_prerolled >= priv->prefetch_budget)
+    return TRUE;
+
+  GST_DEBUG_OBJECT (comp, "Prerolling %s", GST_ELEMENT_NAME (element));
+
+  /* The state stays locked, the composition blocks the pads of its objects
+   * until they are used. The list is reversed once complete */
+  priv->prerolled = g_list_prepend (priv->prerolled, element);
+  priv->n_prerolled++;
+  entry->prerolled = TRUE;
+  g_queue_remove (&priv->paused_cache, element);
+
+  /* Sources keep the seek until their pad is ghosted, so that they preroll
+   * at the right position. Operations only forward seeks upstream and
+   * can't take it before being linked */
+  if (GNL_IS_SOURCE (element) && !(entry->prerollseek &&
+          same_seek (entry->prerollseek, data->seek))) {
+    gst_event_replace (&entry->prerollseek, data->seek);
+    gst_element_send_event (element, gst_event_ref (data->seek));
+  }
+
+  gst_element_set_state (element, GST_STATE_PAUSED);
+
+  return FALSE;
+}
+
+static gboolean
+clear_preroll_seek (GNode * node, GnlComposition * comp)
+{
+  GnlCompositionEntry *entry = COMP_ENTRY (comp, node->data);
+
+  if (entry)
+    gst_event_replace (&entry->prerollseek, NULL);
+
+  return FALSE;
+}
+
+/* TRUE if all the objects of @node are being played or prerolled */
+static gboolean
+stack_is_warm (GnlComposition * comp, GNode * node)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  GnlCompositionEntry *entry = COMP_ENTRY (comp, node->data);
+  GNode *child;
+
+  if (!((priv->current && g_node_find (priv->current, G_IN_ORDER,
+                  G_TRAVERSE_ALL, node->data)) || entry->prerolled))
+    return FALSE;
+
+  for (child = node->children; child; child = child->next)
+    if (!stack_is_warm (comp, child))
+      return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * update_prefetch_stats:
+ *
+ * Records whether the objects of @stack, about to replace the current one
+ * at its end, were all already running or prerolled.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+update_prefetch_stats (GnlComposition * comp, GNode * stack)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+
+  if (!PREFETCH_ZONES (priv) || !stack)
+    return;
+
+  if (stack_is_warm (comp, stack))
+    priv->prefetch_hits++;
+  else
+    priv->prefetch_misses++;
+}
+
+/*
+ * update_prefetch:
+ * @comp: The #GnlComposition
+ * @nextstate: The state the composition is going to
+ *
+ * Prerolls the objects of the stacks following the current one, nearest
+ * first and within the prefetch budget, and puts back in the deactivated
+ * state the ones that were prerolled but are neither used nor about to be
+ * used anymore.
+ *
+ * WITH OBJECTS LOCK TAKEN
+ */
+static void
+update_prefetch (GnlComposition * comp, GstState nextstate)
+{
+  GnlCompositionPrivate *priv = comp->priv;
+  gboolean reverse = (priv->segment->rate < 0.0);
+  GList *prerolled = priv->prerolled, *tmp;
+  GnlPrerollData data = { comp, NULL };
+  GstClockTime ts, start, stop;
+  GnlCutZone *cutzone;
+  GNode *next;
+  guint zone;
+
+  for (tmp = prerolled; tmp; tmp = tmp->next) {
+    GnlCompositionEntry *entry = COMP_ENTRY (comp, tmp->data);
+
+    entry->prerolled = FALSE;
+  }
+  priv->prerolled = NULL;
+  priv->n_prerolled = 0;
+
+  if (!priv->current || nextstate < GST_STATE_PAUSED ||
+      !PREFETCH_ZONES (priv))
+    goto release;
+
+  ts = reverse ? priv->segment_start : priv->segment_stop;
+  ensure_cut_list (comp);
+
+  for (zone = 0; zone < PREFETCH_ZONES (priv); zone++) {
+    if (!GST_CLOCK_TIME_IS_VALID (ts) || (reverse ?
+            (ts <= COMP_REAL_START (comp)) : (ts >= COMP_REAL_STOP (comp))))
+      break;
+
+    /* The next zones are the ones seeks and EOS will use */
+    if ((cutzone = lookup_cut_list (comp, ts, reverse))) {
+      next = cutzone->stack ? g_node_copy (cutzone->stack) : NULL;
+      start = cutzone->stack_start;
+      stop = cutzone->stack_stop;
+    } else
+      next = resolve_stack (comp, ts, reverse, &start, &stop);
+
+    if (!next)
+      break;
+
+    GST_DEBUG_OBJECT (comp, "Prerolling the stack at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (ts));
+    data.seek = reverse ?
+        get_zone_seek_event (comp, next, TRUE, FALSE, start, ts) :
+        get_zone_seek_event (comp, next, TRUE, FALSE, ts, stop);
+    g_node_traverse (next, G_IN_ORDER, G_TRAVERSE_ALL, -1,
+        (GNodeTraverseFunc) preroll_node, &data);
+    gst_event_unref (data.seek);
+    g_node_destroy (next);
+
+    if (priv->n_prerolled >= priv->prefetch_budget)
+      break;
+
+    ts = reverse ? start : stop;
+  }
+
+  priv->prerolled = g_list_reverse (priv->prerolled);
+
+release:
+  for (tmp = prerolled; tmp; tmp = tmp->next) {
+    GstElement *element = (GstElement *) tmp->data;
+    GnlCompositionEntry *entry = COMP_ENTRY (comp, element);
+
+    if (entry->prerolled || (priv->current &&
+            g_node_find (priv->current, G_IN_ORDER, G_TRAVERSE_ALL, element)))
+      continue;
+
+    GST_DEBUG_OBJECT (comp, "%s is not needed anymore",
+        GST_ELEMENT_NAME (element));
+    gst_event_replace (&entry->prerollseek, NULL);
+    deactivate_element (comp, element);
+  }
+
+  g_list_free (prerolled);
+  trim_paused_cache (comp);
 }
 
 /*
@@ -2661,6 +5033,7 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
   gboolean startchanged, stopchanged;
 
   GNode *stack = NULL;
+  guint64 fingerprint = 0;
   gboolean ret = TRUE;
   GList *todeactivate = NULL;
   gboolean samestack = FALSE;
@@ -2688,9 +5061,22 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
       "now really updating the pipeline, current-state:%s",
       gst_element_state_get_name (state));
 
+  /* Let the streaming threads know they can't trust the snapshot until
+   * we are done */
+  publish_snapshot (comp, FALSE);
+
   /* 1. Get new stack and compare it to current one */
-  stack = get_clean_toplevel_stack (comp, &currenttime, &new_start, &new_stop);
-  samestack = are_same_stacks (priv->current, stack);
+  stack = get_clean_toplevel_stack (comp, &currenttime, &new_start, &new_stop,
+      &fingerprint);
+  samestack = (fingerprint == priv->current_fingerprint);
+  GST_LOG_OBJECT (comp, "Stack fingerprint %" G_GINT64_MODIFIER "x, same: %d",
+      fingerprint, samestack);
+
+  /* Only the moves to the next stack at the end of one (the only updates
+   * not modifying the timeline) tell whether prefetching works, seeks and
+   * the first activation can go anywhere */
+  if (!samestack && !modify)
+    update_prefetch_stats (comp, stack);
 
   /* invalidate the stack while modifying it */
   priv->stackvalid = FALSE;
@@ -2729,6 +5115,7 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
   if (priv->current)
     g_node_destroy (priv->current);
   priv->current = NULL;
+  priv->current_fingerprint = 0;
 
   /* 5. deactivate unused elements */
   if (todeactivate) {
@@ -2742,7 +5129,7 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
     for (tmp = todeactivate; tmp; tmp = tmp->next) {
       element = GST_ELEMENT_CAST (tmp->data);
 
-      gst_element_set_state (element, priv->deactivated_elements_state);
+      deactivate_element (comp, element);
       gst_element_set_locked_state (element, TRUE);
       entry = COMP_ENTRY (comp, element);
 
@@ -2761,11 +5148,21 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
   /* 6. Unlock all elements in new stack */
   GST_DEBUG_OBJECT (comp, "Setting current stack");
   priv->current = stack;
+  priv->current_fingerprint = fingerprint;
+
+  /* The objects used again leave the paused cache */
+  if (stack && priv->paused_cache.length)
+    g_node_traverse (stack, G_IN_ORDER, G_TRAVERSE_ALL, -1,
+        (GNodeTraverseFunc) uncache_node, comp);
+  trim_paused_cache (comp);
 
   if (!samestack && stack) {
     GST_DEBUG_OBJECT (comp, "activating objects in new stack to %s",
         gst_element_state_get_name (nextstate));
-    unlock_activate_stack (comp, stack, nextstate);
+    if (priv->parallel_activation && !G_NODE_IS_LEAF (stack))
+      unlock_activate_stack_parallel (comp, stack, nextstate);
+    else
+      unlock_activate_stack (comp, stack, nextstate);
     GST_DEBUG_OBJECT (comp, "Finished activating objects in new stack");
   }
 
@@ -2791,14 +5188,25 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
       /* Get toplevel object source pad */
       if ((pad = get_src_pad (topelement))) {
         GnlCompositionEntry *topentry = COMP_ENTRY (comp, topelement);
+        gboolean sent;
 
         GST_DEBUG_OBJECT (comp,
             "We have a valid toplevel element pad %s:%s",
             GST_DEBUG_PAD_NAME (pad));
 
-        /* Send seek event */
-        GST_LOG_OBJECT (comp, "sending seek event");
-        if (gst_pad_send_event (pad, event)) {
+        /* Send seek event, unless the top-level source was prerolled with
+         * the same one. Sources under operations are seeked again, the
+         * operations expect the flushes on all their inputs */
+        if (topentry->prerollseek && same_seek (topentry->prerollseek, event)) {
+          GST_LOG_OBJECT (comp, "already seeked while prerolling");
+          gst_event_unref (event);
+          sent = TRUE;
+        } else {
+          GST_LOG_OBJECT (comp, "sending seek event");
+          sent = gst_pad_send_event (pad, event);
+        }
+
+        if (sent) {
           /* Unconditionnaly set the ghostpad target to pad */
           GST_LOG_OBJECT (comp,
               "Setting the composition's ghostpad target to %s:%s",
@@ -2833,8 +5241,12 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
       priv->childseek = event;
       ret = TRUE;
     }
+
+    /* The objects in use now need new seeks from us */
+    g_node_traverse (priv->current, G_IN_ORDER, G_TRAVERSE_ALL, -1,
+        (GNodeTraverseFunc) clear_preroll_seek, comp);
   } else {
-    if ((!priv->objects_start) && priv->ghostpad) {
+    if ((!gnl_interval_tree_size (priv->index)) && priv->ghostpad) {
       GST_DEBUG_OBJECT (comp, "composition is now empty, removing ghostpad");
       gnl_composition_remove_ghostpad (comp);
       priv->segment_start = 0;
@@ -2842,6 +5254,9 @@ update_pipeline (GnlComposition * comp, GstClockTime currenttime,
     }
   }
 
+  update_prefetch (comp, nextstate);
+  publish_snapshot (comp, TRUE);
+
   GST_DEBUG_OBJECT (comp, "Returning %d", ret);
   return ret;
 }
@@ -2978,25 +5393,20 @@ gnl_composition_add_object (GstBin * bin, GstElement * element)
 
   /* Special case for default source. */
   if (GNL_OBJECT_IS_EXPANDABLE (element)) {
-    /* It doesn't get added to objects_start and objects_stop. */
+    /* It doesn't get added to the index. */
     priv->expandables = g_list_prepend (priv->expandables, element);
+    invalidate_cut_list (comp);
     goto beach;
   }
 
-  /* add it sorted to the objects list */
-  priv->objects_start = g_list_insert_sorted
-      (priv->objects_start, element, (GCompareFunc) objects_start_compare);
-
-  if (priv->objects_start)
-    GST_LOG_OBJECT (comp,
-        "Head of objects_start is now %s [%" GST_TIME_FORMAT "--%"
-        GST_TIME_FORMAT "]",
-        GST_OBJECT_NAME (priv->objects_start->data),
-        GST_TIME_ARGS (GNL_OBJECT_START (priv->objects_start->data)),
-        GST_TIME_ARGS (GNL_OBJECT_STOP (priv->objects_start->data)));
-
-  priv->objects_stop = g_list_insert_sorted
-      (priv->objects_stop, element, (GCompareFunc) objects_stop_compare);
+  /* add it sorted to the index, or let add-objects do it */
+  if (priv->pending_index) {
+    g_ptr_array_add (priv->pending_index, element);
+  } else {
+    gnl_interval_tree_insert (priv->index, GNL_OBJECT (element));
+    cut_list_add_object (comp, GNL_OBJECT_START (element),
+        GNL_OBJECT_STOP (element));
+  }
 
   /* Now the object is ready to be commited and then used */
 
@@ -3043,19 +5453,45 @@ gnl_composition_remove_object (GstBin * bin, GstElement * element)
   if (GNL_OBJECT_IS_EXPANDABLE (element)) {
     /* Find it in the list */
     priv->expandables = g_list_remove (priv->expandables, element);
+    invalidate_cut_list (comp);
   } else {
-    /* remove it from the objects list and resort the lists */
-    priv->objects_start = g_list_remove (priv->objects_start, element);
-    priv->objects_stop = g_list_remove (priv->objects_stop, element);
-    GST_LOG_OBJECT (element, "Removed from the objects start/stop list");
+    GstClockTime start, stop;
+
+    /* add-objects might not have indexed it yet */
+    if (priv->pending_index)
+      g_ptr_array_remove (priv->pending_index, element);
+
+    /* remove it from the index, unless remove-objects already did, and only
+     * rescan the sources if it was one of the extremities */
+    if (gnl_interval_tree_lookup (priv->index, GNL_OBJECT (element), &start,
+            &stop) && gnl_interval_tree_remove (priv->index,
+            GNL_OBJECT (element))) {
+      cut_list_remove_object (comp, start, stop);
+
+      if (GNL_IS_SOURCE (element) &&
+          (GNL_OBJECT_STOP (element) >= priv->sources_max_stop ||
+              GNL_OBJECT_START (element) <= priv->sources_min_start))
+        update_sources_extents (comp);
+    }
+    GST_LOG_OBJECT (element, "Removed from the objects index");
   }
 
+  if (entry->prerolled) {
+    priv->prerolled = g_list_remove (priv->prerolled, element);
+    priv->n_prerolled--;
+  }
   g_hash_table_remove (priv->objects_hash, element);
+  g_queue_remove (&priv->paused_cache, element);
   update_required = OBJECT_IN_ACTIVE_SEGMENT (comp, element) ||
       (GNL_OBJECT_PRIORITY (element) == G_MAXUINT32) ||
       GNL_OBJECT_IS_EXPANDABLE (element);
 
-  if (G_LIKELY (update_required)) {
+  /* In a transaction, only objects being played can't wait for the end */
+  if (priv->transaction_depth && !(priv->current &&
+          g_node_find (priv->current, G_IN_ORDER, G_TRAVERSE_ALL, element))) {
+    GST_DEBUG_OBJECT (comp, "In a transaction, deferring update");
+    priv->transaction_update = TRUE;
+  } else if (G_LIKELY (update_required)) {
     /* And update the pipeline at current position if needed */
     update_pipeline_at_current_position (comp);
   } else
@@ -55,6 +55,14 @@ struct _GnlComposition
 struct _GnlCompositionClass
 {
   GnlObjectClass parent_class;
+
+  /* Signal method handlers */
+  GArray *(*get_cut_list) (GnlComposition * comp);
+  void (*begin_transaction) (GnlComposition * comp);
+  gboolean (*end_transaction) (GnlComposition * comp);
+  gboolean (*add_objects) (GnlComposition * comp, GPtrArray * objects);
+  gboolean (*remove_objects) (GnlComposition * comp, GPtrArray * objects);
+  void (*commit_async) (GnlComposition * comp, gboolean recurse);
 };
 
 GType gnl_composition_get_type (void);
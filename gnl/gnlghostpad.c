@@ -98,8 +98,10 @@ translate_incoming_seek (GnlObject * object, GstEvent * event)
   }
 
 
-  /* add accurate seekflags */
-  if (G_UNLIKELY (!(flags & GST_SEEK_FLAG_ACCURATE))) {
+  /* add accurate seekflags, unless a keyframe seek was asked for */
+  if (flags & GST_SEEK_FLAG_KEY_UNIT) {
+    GST_DEBUG_OBJECT (object, "keyframe seek, not adding accurate flag");
+  } else if (G_UNLIKELY (!(flags & GST_SEEK_FLAG_ACCURATE))) {
     GST_DEBUG_OBJECT (object, "Adding GST_SEEK_FLAG_ACCURATE");
     flags |= GST_SEEK_FLAG_ACCURATE;
   } else {
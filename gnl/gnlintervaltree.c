@@ -0,0 +1,879 @@
+/* Gnonlin
+ *
+ * gnlintervaltree.c: Timeline index for compositions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gnl.h"
+
+/*
+ * Every object is stored in two AVL trees, one sorted by start time and one
+ * sorted by stop time (ties are broken by priority, then by address so that
+ * the order is total). The nodes of both trees live in the same
+ * GnlIntervalItem which also holds the values the object had when it was
+ * (re)indexed.
+ */
+
+enum
+{
+  KEY_START,
+  KEY_STOP,
+  N_KEYS
+};
+
+typedef struct _GnlIntervalNode GnlIntervalNode;
+typedef struct _GnlIntervalItem GnlIntervalItem;
+
+struct _GnlIntervalNode
+{
+  GnlIntervalItem *item;
+  GnlIntervalNode *left;
+  GnlIntervalNode *right;
+  gint height;
+
+  /* Subtree augmentation */
+  GstClockTime max_stop;
+  guint32 min_prio;
+  guint32 max_prio;
+};
+
+struct _GnlIntervalItem
+{
+  GnlObject *object;
+
+  GstClockTime start;
+  GstClockTime stop;
+  guint32 priority;
+
+  GnlIntervalNode node[N_KEYS];
+};
+
+struct _GnlIntervalTree
+{
+  GnlIntervalNode *root[N_KEYS];
+
+  /* GnlObject -> GnlIntervalItem */
+  GHashTable *items;
+};
+
+#define NODE_HEIGHT(node) ((node) ? (node)->height : 0)
+
+#define ITEM_MATCHES(item, maxprio, activeonly)  \
+  (((item)->priority <= (maxprio)) &&            \
+   ((!(activeonly)) || (item)->object->active))
+
+static void
+item_free (GnlIntervalItem * item)
+{
+  g_slice_free (GnlIntervalItem, item);
+}
+
+static void
+item_snapshot (GnlIntervalItem * item)
+{
+  item->start = item->object->start;
+  item->stop = item->object->stop;
+  item->priority = item->object->priority;
+}
+
+static gint
+item_compare (GnlIntervalItem * a, GnlIntervalItem * b, gint key)
+{
+  GstClockTime ka, kb;
+
+  if (key == KEY_START) {
+    ka = a->start;
+    kb = b->start;
+  } else {
+    ka = a->stop;
+    kb = b->stop;
+  }
+
+  if (ka < kb)
+    return -1;
+  if (ka > kb)
+    return 1;
+
+  if (a->priority < b->priority)
+    return -1;
+  if (a->priority > b->priority)
+    return 1;
+
+  if (a < b)
+    return -1;
+  if (a > b)
+    return 1;
+
+  return 0;
+}
+
+static void
+node_update (GnlIntervalNode * node)
+{
+  GnlIntervalNode *child;
+  gint i;
+
+  node->height = MAX (NODE_HEIGHT (node->left), NODE_HEIGHT (node->right)) + 1;
+  node->max_stop = node->item->stop;
+  node->min_prio = node->max_prio = node->item->priority;
+
+  for (i = 0; i < 2; i++) {
+    child = i ? node->right : node->left;
+    if (!child)
+      continue;
+
+    node->max_stop = MAX (node->max_stop, child->max_stop);
+    node->min_prio = MIN (node->min_prio, child->min_prio);
+    node->max_prio = MAX (node->max_prio, child->max_prio);
+  }
+}
+
+static GnlIntervalNode *
+rotate_right (GnlIntervalNode * node)
+{
+  GnlIntervalNode *pivot = node->left;
+
+  node->left = pivot->right;
+  pivot->right = node;
+  node_update (node);
+  node_update (pivot);
+
+  return pivot;
+}
+
+static GnlIntervalNode *
+rotate_left (GnlIntervalNode * node)
+{
+  GnlIntervalNode *pivot = node->right;
+
+  node->right = pivot->left;
+  pivot->left = node;
+  node_update (node);
+  node_update (pivot);
+
+  return pivot;
+}
+
+static GnlIntervalNode *
+node_balance (GnlIntervalNode * node)
+{
+  gint balance;
+
+  node_update (node);
+  balance = NODE_HEIGHT (node->left) - NODE_HEIGHT (node->right);
+
+  if (balance > 1) {
+    if (NODE_HEIGHT (node->left->left) < NODE_HEIGHT (node->left->right))
+      node->left = rotate_left (node->left);
+    return rotate_right (node);
+  }
+
+  if (balance < -1) {
+    if (NODE_HEIGHT (node->right->right) < NODE_HEIGHT (node->right->left))
+      node->right = rotate_right (node->right);
+    return rotate_left (node);
+  }
+
+  return node;
+}
+
+static GnlIntervalNode *
+node_insert (GnlIntervalNode * node, GnlIntervalNode * new, gint key)
+{
+  if (!node) {
+    new->left = new->right = NULL;
+    node_update (new);
+    return new;
+  }
+
+  if (item_compare (new->item, node->item, key) < 0)
+    node->left = node_insert (node->left, new, key);
+  else
+    node->right = node_insert (node->right, new, key);
+
+  return node_balance (node);
+}
+
+static GnlIntervalNode *
+node_remove_min (GnlIntervalNode * node, GnlIntervalNode ** min)
+{
+  if (!node->left) {
+    *min = node;
+    return node->right;
+  }
+
+  node->left = node_remove_min (node->left, min);
+
+  return node_balance (node);
+}
+
+static GnlIntervalNode *
+node_remove (GnlIntervalNode * node, GnlIntervalItem * item, gint key)
+{
+  GnlIntervalNode *min;
+  gint cmp;
+
+  if (!node)
+    return NULL;
+
+  cmp = item_compare (item, node->item, key);
+  if (cmp < 0) {
+    node->left = node_remove (node->left, item, key);
+  } else if (cmp > 0) {
+    node->right = node_remove (node->right, item, key);
+  } else {
+    if (!node->right)
+      return node->left;
+
+    node->right = node_remove_min (node->right, &min);
+    min->left = node->left;
+    min->right = node->right;
+
+    return node_balance (min);
+  }
+
+  return node_balance (node);
+}
+
+static void
+tree_link (GnlIntervalTree * tree, GnlIntervalItem * item)
+{
+  gint key;
+
+  for (key = 0; key < N_KEYS; key++) {
+    item->node[key].item = item;
+    tree->root[key] = node_insert (tree->root[key], &item->node[key], key);
+  }
+}
+
+static void
+tree_unlink (GnlIntervalTree * tree, GnlIntervalItem * item)
+{
+  gint key;
+
+  for (key = 0; key < N_KEYS; key++)
+    tree->root[key] = node_remove (tree->root[key], item, key);
+}
+
+static gint
+item_compare_indirect (GnlIntervalItem ** a, GnlIntervalItem ** b,
+    gpointer key)
+{
+  return item_compare (*a, *b, GPOINTER_TO_INT (key));
+}
+
+/* Builds a perfectly balanced tree out of sorted items */
+static GnlIntervalNode *
+node_build (GnlIntervalItem ** items, guint n, gint key)
+{
+  GnlIntervalNode *node;
+  guint mid;
+
+  if (!n)
+    return NULL;
+
+  mid = n / 2;
+  node = &items[mid]->node[key];
+  node->item = items[mid];
+  node->left = node_build (items, mid, key);
+  node->right = node_build (items + mid + 1, n - mid - 1, key);
+  node_update (node);
+
+  return node;
+}
+
+/* Rebuilds both trees from the items table in O(n log n) */
+static void
+tree_rebuild (GnlIntervalTree * tree)
+{
+  GnlIntervalItem **items;
+  GHashTableIter iter;
+  gpointer value;
+  guint n = 0;
+  gint key;
+
+  items = g_new (GnlIntervalItem *, g_hash_table_size (tree->items) + 1);
+
+  g_hash_table_iter_init (&iter, tree->items);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    items[n++] = value;
+
+  for (key = 0; key < N_KEYS; key++) {
+    g_qsort_with_data (items, n, sizeof (GnlIntervalItem *),
+        (GCompareDataFunc) item_compare_indirect, GINT_TO_POINTER (key));
+    tree->root[key] = node_build (items, n, key);
+  }
+
+  g_free (items);
+}
+
+GnlIntervalTree *
+gnl_interval_tree_new (void)
+{
+  GnlIntervalTree *tree = g_slice_new0 (GnlIntervalTree);
+
+  tree->items = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) item_free);
+
+  return tree;
+}
+
+void
+gnl_interval_tree_free (GnlIntervalTree * tree)
+{
+  g_hash_table_destroy (tree->items);
+  g_slice_free (GnlIntervalTree, tree);
+}
+
+/*
+ * gnl_interval_tree_insert:
+ *
+ * Index @object with its current start/stop/priority. The object must not
+ * already be in the tree.
+ */
+void
+gnl_interval_tree_insert (GnlIntervalTree * tree, GnlObject * object)
+{
+  GnlIntervalItem *item;
+
+  g_return_if_fail (!g_hash_table_contains (tree->items, object));
+
+  item = g_slice_new0 (GnlIntervalItem);
+  item->object = object;
+  item_snapshot (item);
+
+  tree_link (tree, item);
+  g_hash_table_insert (tree->items, object, item);
+}
+
+/*
+ * gnl_interval_tree_insert_many:
+ *
+ * Index @n_objects objects at once. If they are more than the objects
+ * already indexed, the trees are rebuilt in one go instead of inserting the
+ * objects one by one.
+ */
+void
+gnl_interval_tree_insert_many (GnlIntervalTree * tree, GnlObject ** objects,
+    guint n_objects)
+{
+  GnlIntervalItem *item;
+  gboolean rebuild;
+  guint i;
+
+  rebuild = n_objects > g_hash_table_size (tree->items);
+
+  for (i = 0; i < n_objects; i++) {
+    if (g_hash_table_contains (tree->items, objects[i]))
+      continue;
+
+    item = g_slice_new0 (GnlIntervalItem);
+    item->object = objects[i];
+    item_snapshot (item);
+
+    if (!rebuild)
+      tree_link (tree, item);
+    g_hash_table_insert (tree->items, objects[i], item);
+  }
+
+  if (rebuild)
+    tree_rebuild (tree);
+}
+
+gboolean
+gnl_interval_tree_remove (GnlIntervalTree * tree, GnlObject * object)
+{
+  GnlIntervalItem *item = g_hash_table_lookup (tree->items, object);
+
+  if (!item)
+    return FALSE;
+
+  tree_unlink (tree, item);
+  g_hash_table_remove (tree->items, object);
+
+  return TRUE;
+}
+
+/*
+ * gnl_interval_tree_remove_many:
+ *
+ * Removes @n_objects objects from the index at once, rebuilding the trees
+ * if it is cheaper than unlinking them one by one.
+ *
+ * Returns: The number of objects that were removed.
+ */
+guint
+gnl_interval_tree_remove_many (GnlIntervalTree * tree, GnlObject ** objects,
+    guint n_objects)
+{
+  GnlIntervalItem *item;
+  gboolean rebuild;
+  guint i, removed = 0;
+
+  rebuild = 2 * n_objects > g_hash_table_size (tree->items);
+
+  for (i = 0; i < n_objects; i++) {
+    if (!(item = g_hash_table_lookup (tree->items, objects[i])))
+      continue;
+
+    if (!rebuild)
+      tree_unlink (tree, item);
+    g_hash_table_remove (tree->items, objects[i]);
+    removed++;
+  }
+
+  if (rebuild && removed)
+    tree_rebuild (tree);
+
+  return removed;
+}
+
+/*
+ * gnl_interval_tree_update:
+ *
+ * Re-index @object if its start, stop or priority changed since it was last
+ * indexed.
+ *
+ * Returns: TRUE if the object was moved in the index.
+ */
+gboolean
+gnl_interval_tree_update (GnlIntervalTree * tree, GnlObject * object)
+{
+  GnlIntervalItem *item = g_hash_table_lookup (tree->items, object);
+
+  if (!item)
+    return FALSE;
+
+  if (item->start == object->start && item->stop == object->stop &&
+      item->priority == object->priority)
+    return FALSE;
+
+  tree_unlink (tree, item);
+  item_snapshot (item);
+  tree_link (tree, item);
+
+  return TRUE;
+}
+
+/*
+ * gnl_interval_tree_lookup:
+ * @start: (out) (allow-none): Set to the start @object was indexed with
+ * @stop: (out) (allow-none): Set to the stop @object was indexed with
+ *
+ * Returns: TRUE if @object is in the index.
+ */
+gboolean
+gnl_interval_tree_lookup (GnlIntervalTree * tree, GnlObject * object,
+    GstClockTime * start, GstClockTime * stop)
+{
+  GnlIntervalItem *item = g_hash_table_lookup (tree->items, object);
+
+  if (!item)
+    return FALSE;
+
+  if (start)
+    *start = item->start;
+  if (stop)
+    *stop = item->stop;
+
+  return TRUE;
+}
+
+guint
+gnl_interval_tree_size (GnlIntervalTree * tree)
+{
+  return g_hash_table_size (tree->items);
+}
+
+typedef struct
+{
+  gpointer func;
+  gpointer user_data;
+} ForeachData;
+
+static void
+foreach_item (GnlObject * object, GnlIntervalItem * item, ForeachData * data)
+{
+  ((GFunc) data->func) (object, data->user_data);
+}
+
+static gboolean
+find_item (GnlObject * object, GnlIntervalItem * item, ForeachData * data)
+{
+  return ((GnlIntervalTreeFindFunc) data->func) (object, data->user_data);
+}
+
+/*
+ * gnl_interval_tree_foreach:
+ *
+ * Calls @func on every indexed object, in no particular order. @func can
+ * call gnl_interval_tree_update() but must not insert or remove objects.
+ */
+void
+gnl_interval_tree_foreach (GnlIntervalTree * tree, GFunc func,
+    gpointer user_data)
+{
+  ForeachData data = { func, user_data };
+
+  g_hash_table_foreach (tree->items, (GHFunc) foreach_item, &data);
+}
+
+/*
+ * gnl_interval_tree_find:
+ *
+ * Returns: The first object for which @func returns TRUE, or NULL.
+ */
+GnlObject *
+gnl_interval_tree_find (GnlIntervalTree * tree, GnlIntervalTreeFindFunc func,
+    gpointer user_data)
+{
+  ForeachData data = { func, user_data };
+  GnlIntervalItem *item;
+
+  item = g_hash_table_find (tree->items, (GHRFunc) find_item, &data);
+
+  return item ? item->object : NULL;
+}
+
+/*
+ * gnl_interval_tree_get_first:
+ *
+ * Returns: The object with the smallest start time, or NULL if the tree is
+ * empty.
+ */
+GnlObject *
+gnl_interval_tree_get_first (GnlIntervalTree * tree)
+{
+  GnlIntervalNode *node = tree->root[KEY_START];
+
+  if (!node)
+    return NULL;
+
+  while (node->left)
+    node = node->left;
+
+  return node->item->object;
+}
+
+/*
+ * gnl_interval_tree_get_last:
+ *
+ * Returns: The object with the biggest stop time, or NULL if the tree is
+ * empty.
+ */
+GnlObject *
+gnl_interval_tree_get_last (GnlIntervalTree * tree)
+{
+  GnlIntervalNode *node = tree->root[KEY_STOP];
+
+  if (!node)
+    return NULL;
+
+  while (node->right)
+    node = node->right;
+
+  return node->item->object;
+}
+
+/*
+ * Overlap iteration
+ *
+ * The iterator does a best-first walk of the start-sorted tree. Its heap
+ * holds both subtrees, keyed by the smallest priority they contain, and
+ * objects, keyed by their own priority. Subtrees are only expanded when
+ * they reach the top of the heap, so objects come out in priority order
+ * and hidden ones are never visited if the caller stops early.
+ */
+
+typedef struct
+{
+  GnlIntervalNode *node;
+  guint32 key;
+  gboolean subtree;
+} IterEntry;
+
+struct _GnlIntervalTreeIter
+{
+  GstClockTime timestamp;
+  guint32 priority;
+  gboolean activeonly;
+  gboolean reverse;
+
+  /* Binary heap of IterEntry */
+  GArray *heap;
+};
+
+static inline gboolean
+entry_before (IterEntry * a, IterEntry * b)
+{
+  if (a->key != b->key)
+    return a->key < b->key;
+
+  /* Give out objects before expanding subtrees */
+  return !a->subtree && b->subtree;
+}
+
+static void
+iter_push (GnlIntervalTreeIter * iter, GnlIntervalNode * node,
+    gboolean subtree)
+{
+  GArray *heap = iter->heap;
+  IterEntry entry;
+  guint i, parent;
+
+  if (subtree) {
+    if (!node)
+      return;
+
+    /* Nothing in this subtree reaches @timestamp or is high enough */
+    if (iter->reverse ? (node->max_stop < iter->timestamp) :
+        (node->max_stop <= iter->timestamp))
+      return;
+    if (node->max_prio < iter->priority)
+      return;
+  }
+
+  entry.node = node;
+  entry.key = subtree ? node->min_prio : node->item->priority;
+  entry.subtree = subtree;
+
+  g_array_append_val (heap, entry);
+
+  for (i = heap->len - 1; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+    if (!entry_before (&entry, &g_array_index (heap, IterEntry, parent)))
+      break;
+    g_array_index (heap, IterEntry, i) =
+        g_array_index (heap, IterEntry, parent);
+  }
+
+  g_array_index (heap, IterEntry, i) = entry;
+}
+
+static IterEntry
+iter_pop (GnlIntervalTreeIter * iter)
+{
+  GArray *heap = iter->heap;
+  IterEntry top, last;
+  guint i, child;
+
+  top = g_array_index (heap, IterEntry, 0);
+  last = g_array_index (heap, IterEntry, heap->len - 1);
+  g_array_set_size (heap, heap->len - 1);
+
+  for (i = 0; (child = 2 * i + 1) < heap->len; i = child) {
+    if (child + 1 < heap->len &&
+        entry_before (&g_array_index (heap, IterEntry, child + 1),
+            &g_array_index (heap, IterEntry, child)))
+      child++;
+    if (!entry_before (&g_array_index (heap, IterEntry, child), &last))
+      break;
+    g_array_index (heap, IterEntry, i) =
+        g_array_index (heap, IterEntry, child);
+  }
+
+  if (heap->len)
+    g_array_index (heap, IterEntry, i) = last;
+
+  return top;
+}
+
+/*
+ * gnl_interval_tree_iter_new:
+ * @timestamp: The #GstClockTime to look at
+ * @priority: The minimum priority of the returned objects
+ * @activeonly: Only return active objects if TRUE
+ * @reverse: Whether we are looking at the timeline backwards
+ *
+ * Creates an iterator over the objects for which start <= @timestamp < stop
+ * (or start < @timestamp <= stop if @reverse is TRUE), by increasing
+ * priority. The tree must not be modified while the iterator is used.
+ *
+ * Returns: A new iterator, free with gnl_interval_tree_iter_free().
+ */
+GnlIntervalTreeIter *
+gnl_interval_tree_iter_new (GnlIntervalTree * tree, GstClockTime timestamp,
+    guint32 priority, gboolean activeonly, gboolean reverse)
+{
+  GnlIntervalTreeIter *iter = g_slice_new (GnlIntervalTreeIter);
+
+  iter->timestamp = timestamp;
+  iter->priority = priority;
+  iter->activeonly = activeonly;
+  iter->reverse = reverse;
+  iter->heap = g_array_sized_new (FALSE, FALSE, sizeof (IterEntry), 16);
+
+  iter_push (iter, tree->root[KEY_START], TRUE);
+
+  return iter;
+}
+
+void
+gnl_interval_tree_iter_free (GnlIntervalTreeIter * iter)
+{
+  g_array_free (iter->heap, TRUE);
+  g_slice_free (GnlIntervalTreeIter, iter);
+}
+
+/*
+ * gnl_interval_tree_iter_peek:
+ *
+ * Returns: The next object that gnl_interval_tree_iter_next() will return,
+ * or NULL if there are no more.
+ */
+GnlObject *
+gnl_interval_tree_iter_peek (GnlIntervalTreeIter * iter)
+{
+  GnlIntervalItem *item;
+  IterEntry entry;
+
+  while (iter->heap->len) {
+    entry = g_array_index (iter->heap, IterEntry, 0);
+    if (!entry.subtree)
+      return entry.node->item->object;
+
+    iter_pop (iter);
+    item = entry.node->item;
+
+    iter_push (iter, entry.node->left, TRUE);
+
+    /* This node and everything on its right start after @timestamp */
+    if (iter->reverse ? (item->start >= iter->timestamp) :
+        (item->start > iter->timestamp))
+      continue;
+
+    iter_push (iter, entry.node->right, TRUE);
+
+    if ((iter->reverse ? (item->stop >= iter->timestamp) :
+            (item->stop > iter->timestamp)) &&
+        (item->priority >= iter->priority) &&
+        ((!iter->activeonly) || item->object->active))
+      iter_push (iter, entry.node, FALSE);
+  }
+
+  return NULL;
+}
+
+/*
+ * gnl_interval_tree_iter_next:
+ *
+ * Returns: The next object by increasing priority, or NULL if there are no
+ * more.
+ */
+GnlObject *
+gnl_interval_tree_iter_next (GnlIntervalTreeIter * iter)
+{
+  GnlObject *object = gnl_interval_tree_iter_peek (iter);
+
+  if (object)
+    iter_pop (iter);
+
+  return object;
+}
+
+static GnlIntervalItem *
+first_start_after (GnlIntervalNode * node, GstClockTime timestamp,
+    guint32 maxpriority, gboolean activeonly)
+{
+  GnlIntervalItem *ret;
+
+  if (!node || node->min_prio > maxpriority)
+    return NULL;
+
+  /* Only look on the left if this node is already after @timestamp */
+  if (node->item->start > timestamp) {
+    if ((ret = first_start_after (node->left, timestamp, maxpriority,
+                activeonly)))
+      return ret;
+
+    if (ITEM_MATCHES (node->item, maxpriority, activeonly))
+      return node->item;
+  }
+
+  return first_start_after (node->right, timestamp, maxpriority, activeonly);
+}
+
+static GnlIntervalItem *
+last_stop_before (GnlIntervalNode * node, GstClockTime timestamp,
+    guint32 maxpriority, gboolean activeonly)
+{
+  GnlIntervalItem *ret;
+
+  if (!node || node->min_prio > maxpriority)
+    return NULL;
+
+  if (node->item->stop < timestamp) {
+    if ((ret = last_stop_before (node->right, timestamp, maxpriority,
+                activeonly)))
+      return ret;
+
+    if (ITEM_MATCHES (node->item, maxpriority, activeonly))
+      return node->item;
+  }
+
+  return last_stop_before (node->left, timestamp, maxpriority, activeonly);
+}
+
+/*
+ * gnl_interval_tree_next_start:
+ * @maxpriority: The maximum priority (inclusive) of the object to look for
+ * @object: (out) (allow-none): Set to the matching object
+ *
+ * Returns: The smallest start time strictly after @timestamp, or
+ * #GST_CLOCK_TIME_NONE if there is no such object.
+ */
+GstClockTime
+gnl_interval_tree_next_start (GnlIntervalTree * tree, GstClockTime timestamp,
+    guint32 maxpriority, gboolean activeonly, GnlObject ** object)
+{
+  GnlIntervalItem *item;
+
+  item = first_start_after (tree->root[KEY_START], timestamp, maxpriority,
+      activeonly);
+
+  if (object)
+    *object = item ? item->object : NULL;
+
+  return item ? item->start : GST_CLOCK_TIME_NONE;
+}
+
+/*
+ * gnl_interval_tree_prev_stop:
+ * @maxpriority: The maximum priority (inclusive) of the object to look for
+ * @object: (out) (allow-none): Set to the matching object
+ *
+ * Returns: The biggest stop time strictly before @timestamp, or
+ * #GST_CLOCK_TIME_NONE if there is no such object.
+ */
+GstClockTime
+gnl_interval_tree_prev_stop (GnlIntervalTree * tree, GstClockTime timestamp,
+    guint32 maxpriority, gboolean activeonly, GnlObject ** object)
+{
+  GnlIntervalItem *item;
+
+  item = last_stop_before (tree->root[KEY_STOP], timestamp, maxpriority,
+      activeonly);
+
+  if (object)
+    *object = item ? item->object : NULL;
+
+  return item ? item->stop : GST_CLOCK_TIME_NONE;
+}
@@ -0,0 +1,89 @@
+/* Gnonlin
+ *
+ * gnlintervaltree.h: Header for the composition timeline index
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GNL_INTERVAL_TREE_H__
+#define __GNL_INTERVAL_TREE_H__
+
+#include <gst/gst.h>
+
+#include "gnltypes.h"
+
+G_BEGIN_DECLS
+
+/*
+ * GnlIntervalTree:
+ *
+ * Index of the #GnlObject contained in a composition, ordered both by start
+ * and by stop time. Every node is augmented with the biggest stop time and
+ * the priority range of its subtree so that overlap and neighbour queries
+ * only visit the branches that can contain results.
+ *
+ * The start/stop/priority of an object are copied when it is inserted and
+ * refreshed with gnl_interval_tree_update(), the index therefore always
+ * reflects the last commited values.
+ *
+ * Not MT-safe, the owner is responsible for locking.
+ */
+typedef struct _GnlIntervalTree GnlIntervalTree;
+typedef struct _GnlIntervalTreeIter GnlIntervalTreeIter;
+
+typedef gboolean (*GnlIntervalTreeFindFunc) (GnlObject * object,
+    gpointer user_data);
+
+GnlIntervalTree *gnl_interval_tree_new (void);
+void gnl_interval_tree_free (GnlIntervalTree * tree);
+
+void gnl_interval_tree_insert (GnlIntervalTree * tree, GnlObject * object);
+gboolean gnl_interval_tree_remove (GnlIntervalTree * tree, GnlObject * object);
+void gnl_interval_tree_insert_many (GnlIntervalTree * tree,
+    GnlObject ** objects, guint n_objects);
+guint gnl_interval_tree_remove_many (GnlIntervalTree * tree,
+    GnlObject ** objects, guint n_objects);
+gboolean gnl_interval_tree_update (GnlIntervalTree * tree, GnlObject * object);
+gboolean gnl_interval_tree_lookup (GnlIntervalTree * tree, GnlObject * object,
+    GstClockTime * start, GstClockTime * stop);
+
+guint gnl_interval_tree_size (GnlIntervalTree * tree);
+void gnl_interval_tree_foreach (GnlIntervalTree * tree, GFunc func,
+    gpointer user_data);
+GnlObject *gnl_interval_tree_find (GnlIntervalTree * tree,
+    GnlIntervalTreeFindFunc func, gpointer user_data);
+
+GnlObject *gnl_interval_tree_get_first (GnlIntervalTree * tree);
+GnlObject *gnl_interval_tree_get_last (GnlIntervalTree * tree);
+
+GnlIntervalTreeIter *gnl_interval_tree_iter_new (GnlIntervalTree * tree,
+    GstClockTime timestamp, guint32 priority, gboolean activeonly,
+    gboolean reverse);
+void gnl_interval_tree_iter_free (GnlIntervalTreeIter * iter);
+GnlObject *gnl_interval_tree_iter_peek (GnlIntervalTreeIter * iter);
+GnlObject *gnl_interval_tree_iter_next (GnlIntervalTreeIter * iter);
+
+GstClockTime gnl_interval_tree_next_start (GnlIntervalTree * tree,
+    GstClockTime timestamp, guint32 maxpriority, gboolean activeonly,
+    GnlObject ** object);
+GstClockTime gnl_interval_tree_prev_stop (GnlIntervalTree * tree,
+    GstClockTime timestamp, guint32 maxpriority, gboolean activeonly,
+    GnlObject ** object);
+
+G_END_DECLS
+
+#endif /* __GNL_INTERVAL_TREE_H__ */
@@ -86,11 +86,33 @@ enum
   PROP_ACTIVE,
   PROP_CAPS,
   PROP_EXPANDABLE,
+  PROP_SEEK_ACCURACY,
   PROP_LAST
 };
 
 static GParamSpec *properties[PROP_LAST];
 
+GType
+gnl_seek_accuracy_get_type (void)
+{
+  static gsize type = 0;
+  static const GEnumValue values[] = {
+    {GNL_SEEK_ACCURACY_ACCURATE, "Seek to the exact position", "accurate"},
+    {GNL_SEEK_ACCURACY_KEYFRAME, "Seek to the nearest keyframe", "keyframe"},
+    {GNL_SEEK_ACCURACY_REFINE,
+        "Seek to the nearest keyframe, then to the exact position when idle",
+        "refine"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType tmp = g_enum_register_static ("GnlSeekAccuracy", values);
+    g_once_init_leave (&type, tmp);
+  }
+
+  return (GType) type;
+}
+
 static void gnl_object_dispose (GObject * object);
 
 static void gnl_object_set_property (GObject * object, guint prop_id,
@@ -240,6 +262,24 @@ gnl_object_class_init (GnlObjectClass * klass)
       G_PARAM_READWRITE);
   g_object_class_install_property (gobject_class, PROP_EXPANDABLE,
       properties[PROP_EXPANDABLE]);
+
+  /**
+   * GnlObject:seek-accuracy
+   *
+   * How accurately the flushing seeks a #GnlComposition receives are done.
+   * Keyframe seeks are much faster to show a frame when scrubbing. With
+   * %GNL_SEEK_ACCURACY_REFINE, the composition seeks again to the exact
+   * position once the seeks stop, unless it started playing meanwhile.
+   *
+   * The seeks done to switch stacks stay accurate, and the other objects
+   * only follow the seeks of their composition.
+   */
+  properties[PROP_SEEK_ACCURACY] =
+      g_param_spec_enum ("seek-accuracy", "Seek accuracy",
+      "How accurately seeks are done", GNL_TYPE_SEEK_ACCURACY,
+      GNL_SEEK_ACCURACY_ACCURATE, G_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_SEEK_ACCURACY,
+      properties[PROP_SEEK_ACCURACY]);
 }
 
 static void
@@ -509,6 +549,9 @@ gnl_object_set_property (GObject * object, guint prop_id,
       else
         GST_OBJECT_FLAG_UNSET (gnlobject, GNL_OBJECT_EXPANDABLE);
       break;
+    case PROP_SEEK_ACCURACY:
+      gnlobject->seek_accuracy = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -549,6 +592,9 @@ gnl_object_get_property (GObject * object, guint prop_id,
     case PROP_EXPANDABLE:
       g_value_set_boolean (value, GNL_OBJECT_IS_EXPANDABLE (object));
       break;
+    case PROP_SEEK_ACCURACY:
+      g_value_set_enum (value, gnlobject->seek_accuracy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -71,6 +71,23 @@ typedef enum
 #define GNL_OBJECT_IS_COMPOSITION(obj) \
   (GST_OBJECT_FLAG_IS_SET(obj, GNL_OBJECT_COMPOSITION))
 
+/**
+ * GnlSeekAccuracy:
+ * @GNL_SEEK_ACCURACY_ACCURATE: Seek to the exact position
+ * @GNL_SEEK_ACCURACY_KEYFRAME: Seek to the nearest keyframe
+ * @GNL_SEEK_ACCURACY_REFINE: Seek to the nearest keyframe, then to the exact
+ * position once no other seek came for a while
+ */
+typedef enum
+{
+  GNL_SEEK_ACCURACY_ACCURATE,
+  GNL_SEEK_ACCURACY_KEYFRAME,
+  GNL_SEEK_ACCURACY_REFINE
+} GnlSeekAccuracy;
+
+#define GNL_TYPE_SEEK_ACCURACY (gnl_seek_accuracy_get_type())
+GType gnl_seek_accuracy_get_type (void);
+
 /* For internal usage only */
 #define GNL_OBJECT_START(obj) (GNL_OBJECT_CAST (obj)->start)
 #define GNL_OBJECT_STOP(obj) (GNL_OBJECT_CAST (obj)->stop)
@@ -120,6 +137,9 @@ struct _GnlObject
   GstSeekFlags segment_flags;
   gint64 segment_start;
   gint64 segment_stop;
+
+  /* How accurately seeks are done */
+  GnlSeekAccuracy seek_accuracy;
 };
 
 struct _GnlObjectClass
@@ -41,11 +41,32 @@ GST_STATIC_PAD_TEMPLATE ("src",
 GST_DEBUG_CATEGORY_STATIC (gnlsource);
 #define GST_CAT_DEFAULT gnlsource
 
+enum
+{
+  PROP_0,
+  PROP_REVERSE_CACHE_SIZE,
+  PROP_SEEK_POOL_DEPTH,
+  PROP_SEEK_POOL_PEAK,
+  PROP_LAST
+};
+
+static GParamSpec *properties[PROP_LAST];
+
 #define _do_init \
   GST_DEBUG_CATEGORY_INIT (gnlsource, "gnlsource", GST_DEBUG_FG_BLUE | GST_DEBUG_BOLD, "GNonLin Source Element");
 #define gnl_source_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GnlSource, gnl_source, GNL_TYPE_OBJECT, _do_init);
 
+/* Buffers decoded in reverse between two keyframes, covering the media
+ * time from start to stop */
+typedef struct
+{
+  GstClockTime start;
+  GstClockTime stop;
+  GList *buffers;
+  guint64 size;
+} GnlCachedGop;
+
 struct _GnlSourcePrivate
 {
   gboolean dispose_has_run;
@@ -62,6 +83,32 @@ struct _GnlSourcePrivate
   gboolean areblocked;          /* We already got blocked */
   GstPad *ghostedpad;           /* Pad (to be) ghosted */
   GstPad *staticpad;            /* The only pad. We keep an extra ref */
+
+  GstPadEventFunction ghost_event_func; /* gnl event function of the ghostpad */
+
+  /* Reverse playback cache, protected by the OBJECT_LOCK.
+   * reverse_cache_size : maximum size in bytes, 0 to disable it
+   * gops : GnlCachedGop decoded with a negative rate, most recent first
+   * cached_bytes : size of the buffers in gops
+   * filling : GOP being received
+   * reverse : whether the segment on cachepad has a negative rate */
+  guint64 reverse_cache_size;
+  GQueue gops;
+  guint64 cached_bytes;
+  GnlCachedGop *filling;
+  gboolean reverse;
+
+  /* Serving from the reverse cache. The seeking threads and the streaming
+   * thread removing the pad both start and stop it, serve_lock serializes
+   * them and protects the fields below, served is also protected by the
+   * OBJECT_LOCK for the ghostpad task */
+  GMutex serve_lock;
+  GstPad *cachepad;             /* ghosted pad the cache is filled from */
+  GstPad *cacheinternal;        /* internal pad of the ghostpad */
+  gulong cacheprobeid;          /* probe filling the cache */
+  gulong cacheblockid;          /* probe blocking cachepad while serving */
+  gboolean serving;             /* the ghostpad task is pushing from cache */
+  GQueue served;                /* buffers left to push, in order */
 };
 
 static gboolean gnl_source_prepare (GnlObject * object);
@@ -72,12 +119,32 @@ static gboolean gnl_source_add_element (GstBin * bin, GstElement * element);
 static gboolean gnl_source_remove_element (GstBin * bin, GstElement * element);
 
 static void gnl_source_dispose (GObject * object);
+static void gnl_source_finalize (GObject * object);
+static void gnl_source_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gnl_source_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static void trim_reverse_cache (GnlSource * source);
+static void clear_reverse_cache (GnlSource * source);
+static void release_reverse_cache (GnlSource * source);
 
 static gboolean gnl_source_send_event (GstElement * element, GstEvent * event);
 
 static GstPadProbeReturn
 pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info, GnlSource * source);
 
+/* Process-wide pool running ghost_seek_pad() for all the sources, instead
+ * of a new thread each time a source pad gets blocked. ghost_seek_pad()
+ * blocks on the seek and on the composition, so the pool has no limit on
+ * its threads, only on the ones left idle. seek_pool_depth counts the
+ * sources queued or being handled, seek_pool_peak its maximum */
+#define SEEK_POOL_MAX_UNUSED_THREADS 4
+
+static GThreadPool *seek_pool = NULL;
+static gint seek_pool_depth = 0;
+static gint seek_pool_peak = 0;
+
 static gboolean
 gnl_source_control_element_func (GnlSource * source, GstElement * element);
 
@@ -115,6 +182,46 @@ gnl_source_class_init (GnlSourceClass * klass)
   gstelement_class->send_event = GST_DEBUG_FUNCPTR (gnl_source_send_event);
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gnl_source_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gnl_source_finalize);
+  gobject_class->set_property = GST_DEBUG_FUNCPTR (gnl_source_set_property);
+  gobject_class->get_property = GST_DEBUG_FUNCPTR (gnl_source_get_property);
+
+  /**
+   * GnlSource:reverse-cache-size
+   *
+   * Maximum size in bytes of the buffers kept from reverse playback, 0 to
+   * disable. The GOPs decoded while playing backwards are kept, and the
+   * later reverse seeks entirely covered by them are played from this cache
+   * instead of seeking the decoder again. Takes effect the next time the
+   * source pad gets ghosted.
+   */
+  properties[PROP_REVERSE_CACHE_SIZE] =
+      g_param_spec_uint64 ("reverse-cache-size", "Reverse cache size",
+      "Maximum size in bytes of the reverse playback cache (0 = disabled)",
+      0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlSource:seek-pool-depth
+   *
+   * Number of sources, process-wide, whose pad got blocked and that are
+   * waiting to be ghosted and seeked, or being so.
+   */
+  properties[PROP_SEEK_POOL_DEPTH] =
+      g_param_spec_uint ("seek-pool-depth", "Seek pool depth",
+      "Number of sources waiting for their initial seek", 0, G_MAXUINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GnlSource:seek-pool-peak
+   *
+   * Highest #GnlSource:seek-pool-depth reached so far.
+   */
+  properties[PROP_SEEK_POOL_PEAK] =
+      g_param_spec_uint ("seek-pool-peak", "Seek pool peak",
+      "Highest number of sources waiting for their initial seek", 0,
+      G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&gnl_source_src_template));
@@ -129,6 +236,7 @@ gnl_source_init (GnlSource * source)
   source->element = NULL;
   source->priv =
       G_TYPE_INSTANCE_GET_PRIVATE (source, GNL_TYPE_SOURCE, GnlSourcePrivate);
+  g_mutex_init (&source->priv->serve_lock);
 
   GST_DEBUG_OBJECT (source, "Setting GstBin async-handling to TRUE");
   g_object_set (G_OBJECT (source), "async-handling", TRUE, NULL);
@@ -154,9 +262,12 @@ gnl_source_dispose (GObject * object)
   if (priv->event)
     gst_event_unref (priv->event);
 
-  if (priv->ghostpad)
+  if (priv->ghostpad) {
+    release_reverse_cache (source);
     gnl_object_remove_ghost_pad ((GnlObject *) object, priv->ghostpad);
+  }
   priv->ghostpad = NULL;
+  clear_reverse_cache (source);
 
   if (priv->staticpad) {
     gst_object_unref (priv->staticpad);
@@ -166,6 +277,512 @@ gnl_source_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gnl_source_finalize (GObject * object)
+{
+  GnlSource *source = (GnlSource *) object;
+
+  g_mutex_clear (&source->priv->serve_lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gnl_source_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GnlSource *source = (GnlSource *) object;
+
+  switch (prop_id) {
+    case PROP_REVERSE_CACHE_SIZE:
+      GST_OBJECT_LOCK (source);
+      source->priv->reverse_cache_size = g_value_get_uint64 (value);
+      trim_reverse_cache (source);
+      GST_OBJECT_UNLOCK (source);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gnl_source_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GnlSource *source = (GnlSource *) object;
+
+  switch (prop_id) {
+    case PROP_REVERSE_CACHE_SIZE:
+      g_value_set_uint64 (value, source->priv->reverse_cache_size);
+      break;
+    case PROP_SEEK_POOL_DEPTH:
+      g_value_set_uint (value, g_atomic_int_get (&seek_pool_depth));
+      break;
+    case PROP_SEEK_POOL_PEAK:
+      g_value_set_uint (value, g_atomic_int_get (&seek_pool_peak));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/*
+ * Reverse playback cache
+ *
+ * While playing backwards, decoders push each GOP as a run of buffers with
+ * decreasing timestamps. Those runs are kept in priv->gops, up to
+ * reverse_cache_size bytes. A flushing reverse seek whose range is entirely
+ * covered by them is not sent to the decoder: the ghosted pad gets blocked
+ * and a task on the ghostpad pushes the cached buffers in its place,
+ * through the internal pad so they get translated like the decoder output.
+ *
+ * The buffers coming from a buffer pool are copied when cached. Keeping
+ * them would starve the decoders whose pool has a maximum size.
+ */
+
+static void
+cached_gop_free (GnlCachedGop * gop)
+{
+  g_list_free_full (gop->buffers, (GDestroyNotify) gst_buffer_unref);
+  g_slice_free (GnlCachedGop, gop);
+}
+
+/* WITH OBJECT_LOCK TAKEN */
+static void
+trim_reverse_cache (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GnlCachedGop *gop;
+
+  while (priv->cached_bytes > priv->reverse_cache_size &&
+      (gop = g_queue_pop_tail (&priv->gops))) {
+    priv->cached_bytes -= gop->size;
+    cached_gop_free (gop);
+  }
+}
+
+/* WITH OBJECT_LOCK TAKEN */
+static void
+commit_filling_gop (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GnlCachedGop *gop = priv->filling;
+
+  if (!gop)
+    return;
+
+  priv->filling = NULL;
+  if (!gop->buffers) {
+    cached_gop_free (gop);
+    return;
+  }
+
+  GST_LOG_OBJECT (source, "caching GOP %" GST_TIME_FORMAT " -- %"
+      GST_TIME_FORMAT ", %" G_GUINT64_FORMAT " bytes",
+      GST_TIME_ARGS (gop->start), GST_TIME_ARGS (gop->stop), gop->size);
+
+  g_queue_push_head (&priv->gops, gop);
+  priv->cached_bytes += gop->size;
+  trim_reverse_cache (source);
+}
+
+static void
+clear_reverse_cache (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GnlCachedGop *gop;
+
+  GST_OBJECT_LOCK (source);
+  if (priv->filling) {
+    cached_gop_free (priv->filling);
+    priv->filling = NULL;
+  }
+  while ((gop = g_queue_pop_head (&priv->gops)))
+    cached_gop_free (gop);
+  priv->cached_bytes = 0;
+  GST_OBJECT_UNLOCK (source);
+}
+
+static GstPadProbeReturn
+cache_fill_probe (GstPad * pad, GstPadProbeInfo * info, GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+
+  GST_OBJECT_LOCK (source);
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    GstClockTime ts = GST_BUFFER_PTS (buf);
+    GstClockTime duration = GST_BUFFER_DURATION (buf);
+    GnlCachedGop *gop = priv->filling;
+
+    if (!priv->reverse || priv->reverse_cache_size == 0 ||
+        !GST_CLOCK_TIME_IS_VALID (ts) || !GST_CLOCK_TIME_IS_VALID (duration)) {
+      commit_filling_gop (source);
+      goto beach;
+    }
+
+    /* A new GOP starts when the timestamps go up again */
+    if (gop && (GST_BUFFER_IS_DISCONT (buf) || ts >= gop->start)) {
+      commit_filling_gop (source);
+      gop = NULL;
+    }
+
+    if (!gop) {
+      gop = priv->filling = g_slice_new0 (GnlCachedGop);
+      gop->stop = ts + duration;
+    }
+
+    gop->start = ts;
+    if (buf->pool)
+      buf = gst_buffer_copy_region (buf,
+          GST_BUFFER_COPY_ALL | GST_BUFFER_COPY_DEEP, 0, -1);
+    else
+      gst_buffer_ref (buf);
+    gop->buffers = g_list_prepend (gop->buffers, buf);
+    gop->size += gst_buffer_get_size (buf);
+  } else {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_SEGMENT:
+      {
+        const GstSegment *segment;
+
+        gst_event_parse_segment (event, &segment);
+        priv->reverse = (segment->format == GST_FORMAT_TIME &&
+            segment->rate < 0.0);
+        commit_filling_gop (source);
+        break;
+      }
+      case GST_EVENT_FLUSH_STOP:
+      case GST_EVENT_EOS:
+        commit_filling_gop (source);
+        break;
+      default:
+        break;
+    }
+  }
+
+beach:
+  GST_OBJECT_UNLOCK (source);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static gint
+compare_buffer_pts_reverse (GstBuffer * a, GstBuffer * b)
+{
+  if (GST_BUFFER_PTS (a) > GST_BUFFER_PTS (b))
+    return -1;
+  if (GST_BUFFER_PTS (a) < GST_BUFFER_PTS (b))
+    return 1;
+  return 0;
+}
+
+/* Returns the cached buffers covering start to stop, latest first, or NULL
+ * if some part of it isn't cached.
+ * WITH OBJECT_LOCK TAKEN */
+static GList *
+get_cached_range (GnlSource * source, GstClockTime start, GstClockTime stop)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GstClockTime cursor = start;
+  GList *buffers = NULL, *tmp, *tmp2;
+
+  while (cursor < stop) {
+    GnlCachedGop *best = NULL;
+
+    /* The GOP going the furthest among the ones containing cursor */
+    for (tmp = priv->gops.head; tmp; tmp = tmp->next) {
+      GnlCachedGop *gop = tmp->data;
+
+      if (gop->start <= cursor && gop->stop > cursor &&
+          (!best || gop->stop > best->stop))
+        best = gop;
+    }
+
+    if (!best) {
+      g_list_free_full (buffers, (GDestroyNotify) gst_buffer_unref);
+      return NULL;
+    }
+
+    for (tmp2 = best->buffers; tmp2; tmp2 = tmp2->next) {
+      GstBuffer *buf = tmp2->data;
+
+      if (GST_BUFFER_PTS (buf) + GST_BUFFER_DURATION (buf) > cursor &&
+          GST_BUFFER_PTS (buf) < stop)
+        buffers = g_list_prepend (buffers, gst_buffer_ref (buf));
+    }
+    cursor = best->stop;
+  }
+
+  return g_list_sort (buffers, (GCompareFunc) compare_buffer_pts_reverse);
+}
+
+static void
+serve_cache_loop (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GstBuffer *buf;
+  GstFlowReturn ret;
+
+  GST_OBJECT_LOCK (source);
+  buf = g_queue_pop_head (&priv->served);
+  GST_OBJECT_UNLOCK (source);
+
+  if (!buf) {
+    GST_DEBUG_OBJECT (source, "done pushing from the reverse cache");
+    gst_pad_send_event (priv->cacheinternal, gst_event_new_eos ());
+    goto pause;
+  }
+
+  ret = gst_pad_chain (priv->cacheinternal, buf);
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (source, "pausing, reason %s", gst_flow_get_name (ret));
+    goto pause;
+  }
+
+  return;
+
+pause:
+  gst_pad_pause_task (priv->ghostpad);
+}
+
+static GstPadProbeReturn
+cache_block_cb (GstPad * pad, GstPadProbeInfo * info, GnlSource * source)
+{
+  GST_LOG_OBJECT (pad, "blocked while serving from the reverse cache");
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Stops pushing from the cache, the decoder stays blocked.
+ * WITH serve_lock TAKEN */
+static void
+stop_serving (GnlSource * source, guint32 seqnum)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GstEvent *event;
+
+  if (!priv->serving)
+    return;
+
+  GST_DEBUG_OBJECT (source, "stop serving from the reverse cache");
+
+  event = gst_event_new_flush_start ();
+  GST_EVENT_SEQNUM (event) = seqnum;
+  gst_pad_send_event (priv->cacheinternal, event);
+  gst_pad_stop_task (priv->ghostpad);
+  event = gst_event_new_flush_stop (TRUE);
+  GST_EVENT_SEQNUM (event) = seqnum;
+  gst_pad_send_event (priv->cacheinternal, event);
+
+  GST_OBJECT_LOCK (source);
+  g_queue_foreach (&priv->served, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&priv->served);
+  GST_OBJECT_UNLOCK (source);
+
+  priv->serving = FALSE;
+}
+
+/* Lets the decoder push again once we stopped serving.
+ * WITH serve_lock TAKEN */
+static void
+unblock_decoder (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+
+  if (priv->cacheblockid) {
+    gst_pad_remove_probe (priv->cachepad, priv->cacheblockid);
+    priv->cacheblockid = 0;
+  }
+}
+
+/* Plays @event from the cache if it entirely covers it. Takes ownership of
+ * @event if TRUE is returned.
+ * WITH serve_lock TAKEN */
+static gboolean
+serve_from_cache (GnlSource * source, GstEvent * event)
+{
+  GnlSourcePrivate *priv = source->priv;
+  GnlObject *object = (GnlObject *) source;
+  guint32 seqnum = GST_EVENT_SEQNUM (event);
+  GstFormat format;
+  gdouble rate;
+  GstSeekFlags flags;
+  GstSeekType curtype, stoptype;
+  gint64 cur, stop;
+  guint64 mstart, mstop;
+  GstSegment segment;
+  GstEvent *nevent;
+  GList *buffers, *tmp;
+
+  if (!priv->cacheinternal || priv->reverse_cache_size == 0)
+    return FALSE;
+
+  gst_event_parse_seek (event, &rate, &format, &flags,
+      &curtype, &cur, &stoptype, &stop);
+
+  if (rate >= 0.0 || format != GST_FORMAT_TIME ||
+      !(flags & GST_SEEK_FLAG_FLUSH) || curtype != GST_SEEK_TYPE_SET)
+    return FALSE;
+
+  if (stoptype != GST_SEEK_TYPE_SET || stop == -1)
+    stop = object->stop;
+
+  if (!gnl_object_to_media_time (object, cur, &mstart) ||
+      !gnl_object_to_media_time (object, stop, &mstop) || mstart >= mstop)
+    return FALSE;
+
+  GST_OBJECT_LOCK (source);
+  buffers = get_cached_range (source, mstart, mstop);
+  GST_OBJECT_UNLOCK (source);
+
+  if (!buffers)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (source, "serving %" GST_TIME_FORMAT " -- %"
+      GST_TIME_FORMAT " from the reverse cache", GST_TIME_ARGS (mstart),
+      GST_TIME_ARGS (mstop));
+
+  stop_serving (source, seqnum);
+
+  /* Keep the decoder from pushing while we do */
+  if (!priv->cacheblockid)
+    priv->cacheblockid = gst_pad_add_probe (priv->cachepad,
+        GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+        (GstPadProbeCallback) cache_block_cb, source, NULL);
+
+  nevent = gst_event_new_flush_start ();
+  GST_EVENT_SEQNUM (nevent) = seqnum;
+  gst_pad_send_event (priv->cacheinternal, nevent);
+  nevent = gst_event_new_flush_stop (TRUE);
+  GST_EVENT_SEQNUM (nevent) = seqnum;
+  gst_pad_send_event (priv->cacheinternal, nevent);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_segment_do_seek (&segment, rate, GST_FORMAT_TIME, flags,
+      GST_SEEK_TYPE_SET, mstart, GST_SEEK_TYPE_SET, mstop, NULL);
+  nevent = gst_event_new_segment (&segment);
+  GST_EVENT_SEQNUM (nevent) = seqnum;
+  gst_pad_send_event (priv->cacheinternal, nevent);
+
+  GST_OBJECT_LOCK (source);
+  for (tmp = buffers; tmp; tmp = tmp->next)
+    g_queue_push_tail (&priv->served, tmp->data);
+  GST_OBJECT_UNLOCK (source);
+  g_list_free (buffers);
+
+  priv->serving = TRUE;
+  gst_pad_start_task (priv->ghostpad, (GstTaskFunction) serve_cache_loop,
+      source, NULL);
+
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static gboolean
+ghostpad_event_function (GstPad * ghostpad, GstObject * parent,
+    GstEvent * event)
+{
+  GnlSource *source = (GnlSource *) parent;
+  GnlSourcePrivate *priv = source->priv;
+  GstSeekFlags flags;
+  gboolean res;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_SEEK)
+    return priv->ghost_event_func (ghostpad, parent, event);
+
+  g_mutex_lock (&priv->serve_lock);
+  if (!priv->cachepad) {
+    g_mutex_unlock (&priv->serve_lock);
+    return priv->ghost_event_func (ghostpad, parent, event);
+  }
+
+  if (serve_from_cache (source, event)) {
+    g_mutex_unlock (&priv->serve_lock);
+    return TRUE;
+  }
+
+  stop_serving (source, GST_EVENT_SEQNUM (event));
+
+  /* The flush of the seek drops what the decoder was blocked with, a
+   * non-flushing seek would wait for it to be pushed */
+  gst_event_parse_seek (event, NULL, NULL, &flags, NULL, NULL, NULL, NULL);
+  if (!(flags & GST_SEEK_FLAG_FLUSH))
+    unblock_decoder (source);
+  g_mutex_unlock (&priv->serve_lock);
+
+  /* Not holding serve_lock, the decoder might be removing its pad */
+  res = priv->ghost_event_func (ghostpad, parent, event);
+
+  /* Unless another seek got served from the cache meanwhile */
+  g_mutex_lock (&priv->serve_lock);
+  if (!priv->serving)
+    unblock_decoder (source);
+  g_mutex_unlock (&priv->serve_lock);
+
+  return res;
+}
+
+/* Sets up the reverse cache for the newly ghosted @pad */
+static void
+setup_reverse_cache (GnlSource * source, GstPad * pad)
+{
+  GnlSourcePrivate *priv = source->priv;
+
+  priv->ghost_event_func = GST_PAD_EVENTFUNC (priv->ghostpad);
+  gst_pad_set_event_function (priv->ghostpad,
+      GST_DEBUG_FUNCPTR (ghostpad_event_function));
+
+  if (priv->reverse_cache_size == 0)
+    return;
+
+  g_mutex_lock (&priv->serve_lock);
+  priv->cachepad = gst_object_ref (pad);
+  priv->cacheinternal =
+      (GstPad *) gst_proxy_pad_get_internal ((GstProxyPad *) priv->ghostpad);
+  priv->cacheprobeid = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) cache_fill_probe, source, NULL);
+  g_mutex_unlock (&priv->serve_lock);
+}
+
+/* Stops using the reverse cache before the ghostpad goes away, the cached
+ * buffers are kept */
+static void
+release_reverse_cache (GnlSource * source)
+{
+  GnlSourcePrivate *priv = source->priv;
+
+  g_mutex_lock (&priv->serve_lock);
+  stop_serving (source, gst_util_seqnum_next ());
+  unblock_decoder (source);
+
+  if (priv->cacheprobeid) {
+    gst_pad_remove_probe (priv->cachepad, priv->cacheprobeid);
+    priv->cacheprobeid = 0;
+  }
+  if (priv->cachepad) {
+    gst_object_unref (priv->cachepad);
+    priv->cachepad = NULL;
+  }
+  if (priv->cacheinternal) {
+    gst_object_unref (priv->cacheinternal);
+    priv->cacheinternal = NULL;
+  }
+  g_mutex_unlock (&priv->serve_lock);
+
+  GST_OBJECT_LOCK (source);
+  commit_filling_gop (source);
+  priv->reverse = FALSE;
+  GST_OBJECT_UNLOCK (source);
+}
+
 static void
 element_pad_added_cb (GstElement * element G_GNUC_UNUSED, GstPad * pad,
     GnlSource * source)
@@ -228,6 +845,7 @@ element_pad_removed_cb (GstElement * element G_GNUC_UNUSED, GstPad * pad,
         priv->probeid = 0;
       }
 
+      release_reverse_cache (source);
       gnl_object_remove_ghost_pad ((GnlObject *) source, priv->ghostpad);
       priv->ghostpad = NULL;
     }
@@ -288,8 +906,8 @@ get_valid_src_pad (GnlSource * source, GstElement * element, GstPad ** pad)
   return res;
 }
 
-static gpointer
-ghost_seek_pad (GnlSource * source)
+static void
+ghost_seek_pad (GnlSource * source, gpointer udata)
 {
   GnlSourcePrivate *priv = source->priv;
   GstPad *pad = priv->ghostedpad;
@@ -301,6 +919,7 @@ ghost_seek_pad (GnlSource * source)
 
   priv->ghostpad = gnl_object_ghost_pad ((GnlObject *) source,
       GST_PAD_NAME (pad), pad);
+  setup_reverse_cache (source, pad);
   GST_DEBUG_OBJECT (source, "emitting no more pads");
   gst_pad_set_active (priv->ghostpad, TRUE);
 
@@ -325,7 +944,52 @@ ghost_seek_pad (GnlSource * source)
   priv->pendingblock = FALSE;
 
 beach:
-  return NULL;
+  gst_object_unref (source);
+  g_atomic_int_add (&seek_pool_depth, -1);
+}
+
+static GThreadPool *
+get_seek_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    seek_pool = g_thread_pool_new ((GFunc) ghost_seek_pad, NULL, -1, FALSE,
+        NULL);
+    /* The limit on idle threads is shared by all the pools of the process,
+     * only raise it */
+    if (g_thread_pool_get_max_unused_threads () < SEEK_POOL_MAX_UNUSED_THREADS)
+      g_thread_pool_set_max_unused_threads (SEEK_POOL_MAX_UNUSED_THREADS);
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return seek_pool;
+}
+
+/* Has the seek pool ghost the pad and seek it, once */
+static void
+queue_ghost_seek_pad (GnlSource * source)
+{
+  gboolean queue;
+  gint depth, peak;
+
+  GST_OBJECT_LOCK (source);
+  queue = !source->priv->ghostpad && !source->priv->areblocked;
+  if (queue)
+    source->priv->areblocked = TRUE;
+  GST_OBJECT_UNLOCK (source);
+
+  if (!queue)
+    return;
+
+  depth = g_atomic_int_add (&seek_pool_depth, 1) + 1;
+  do {
+    peak = g_atomic_int_get (&seek_pool_peak);
+  } while (depth > peak &&
+      !g_atomic_int_compare_and_exchange (&seek_pool_peak, peak, depth));
+
+  GST_DEBUG_OBJECT (source, "queueing ghost_seek_pad, %d pending", depth);
+  g_thread_pool_push (get_seek_pool (), gst_object_ref (source), NULL);
 }
 
 static GstPadProbeReturn
@@ -333,19 +997,29 @@ pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info, GnlSource * source)
 {
   GST_DEBUG_OBJECT (pad, "probe callback");
 
-  if (!source->priv->ghostpad && !source->priv->areblocked) {
-    GThread *lthread;
-
-    source->priv->areblocked = TRUE;
-    GST_DEBUG_OBJECT (pad, "starting thread to call ghost_seek_pad");
-    lthread =
-        g_thread_new ("gnlsourceseek", (GThreadFunc) ghost_seek_pad, source);
-    g_thread_unref (lthread);
-  }
+  queue_ghost_seek_pad (source);
 
   return GST_PAD_PROBE_OK;
 }
 
+/**
+ * gnl_source_ghost_pad_now:
+ * @source: a prepared #GnlSource
+ *
+ * Ghosts the pad of the controlled element and sends it the pending seek
+ * without waiting for data to get blocked on it. For subclasses whose
+ * element might have nothing left to push, like a decoder taken over at
+ * EOS.
+ */
+void
+gnl_source_ghost_pad_now (GnlSource * source)
+{
+  if (!source->priv->ghostedpad)
+    return;
+
+  queue_ghost_seek_pad (source);
+}
+
 
 /*
  * has_dynamic_pads
@@ -455,10 +1129,28 @@ gnl_source_remove_element (GstBin * bin, GstElement * element)
   if (pret) {
     /* remove ghostpad */
     if (priv->ghostpad) {
+      release_reverse_cache (source);
       gnl_object_remove_ghost_pad ((GnlObject *) bin, priv->ghostpad);
       priv->ghostpad = NULL;
     }
 
+    /* the cached buffers come from the removed element */
+    clear_reverse_cache (source);
+
+    /* remove a pending block, the pad isn't ours anymore */
+    if (priv->probeid && priv->ghostedpad) {
+      gst_pad_remove_probe (priv->ghostedpad, priv->probeid);
+      priv->probeid = 0;
+    }
+    priv->ghostedpad = NULL;
+    priv->pendingblock = FALSE;
+    priv->areblocked = FALSE;
+
+    if (priv->staticpad) {
+      gst_object_unref (priv->staticpad);
+      priv->staticpad = NULL;
+    }
+
     /* discard events */
     if (priv->event) {
       gst_event_unref (priv->event);
@@ -579,6 +1271,7 @@ gnl_source_cleanup (GnlObject * object)
       }
       gst_object_unref (target);
     }
+    release_reverse_cache (source);
     gnl_object_remove_ghost_pad ((GnlObject *) source, priv->ghostpad);
     priv->ghostpad = NULL;
     priv->ghostedpad = NULL;
@@ -64,5 +64,7 @@ struct _GnlSourceClass
 
 GType gnl_source_get_type (void);
 
+void gnl_source_ghost_pad_now (GnlSource * source);
+
 G_END_DECLS
 #endif /* __GNL_SOURCE_H__ */
@@ -22,6 +22,8 @@
 #include "config.h"
 #endif
 
+#include <glib/gstdio.h>
+
 #include "gnl.h"
 #include "gnlurisource.h"
 
@@ -31,6 +33,22 @@
  * GnlURISource is a #GnlSource which reads and decodes the contents
  * of a given file. The data in the file is decoded using any available
  * GStreamer plugins.
+ *
+ * When #GnlURISource:reuse-decoder is set, the decoding chain is not torn
+ * down when the source goes back to READY. It is kept PAUSED in a pool
+ * shared by all the sources of the process, and another source with the
+ * same uri and caps takes it over instead of building its own. Several
+ * clips cut from the same file thus only pay for typefinding, demuxing and
+ * plugging decoders once, the chain being re-seeked by the composition.
+ * The pool keeps at most 2 chains per uri and 8 overall, dropping the
+ * least recently released ones first, and the chains of a uri are dropped
+ * as soon as no source uses that uri anymore.
+ *
+ * The elements plugged while decoding local files are remembered for the
+ * lifetime of the process, as long as the file size and modification time
+ * don't change. Later activations of a source using the same file try
+ * those elements first. Typefinding still runs each time, the cache only
+ * changes the order in which the candidate elements are tried.
  */
 
 static GstStaticPadTemplate gnl_urisource_src_template =
@@ -52,10 +70,67 @@ enum
 {
   ARG_0,
   ARG_URI,
+  ARG_REUSE_DECODER,
+  ARG_AUTOPLUG_CACHE_HITS,
+  ARG_AUTOPLUG_CACHE_MISSES,
+  ARG_POOLED_DECODERS,
 };
 
+/* A decoding chain released by a source, still PAUSED with its only
+ * source pad blocked */
+typedef struct
+{
+  gchar *uri;
+  GstElement *decoder;
+  GstCaps *caps;
+  GstPad *pad;
+  gulong probeid;
+} GnlPooledDecoder;
+
+/* Maximum number of idle decoding chains kept for a given uri, and for all
+ * the uris together */
+#define MAX_POOLED_DECODERS_PER_URI 2
+#define MAX_POOLED_DECODERS 8
+
+/* uri -> GList of GnlPooledDecoder, most recently released first, all the
+ * pooled chains, most recently released first, and uri -> number of
+ * sources using it */
+G_LOCK_DEFINE_STATIC (decoder_pool);
+static GHashTable *decoder_pool = NULL;
+static GQueue decoder_pool_lru = G_QUEUE_INIT;
+static GHashTable *decoder_pool_users = NULL;
+
+/* The element factory uridecodebin plugged for some caps */
+typedef struct
+{
+  GstCaps *caps;
+  GstElementFactory *factory;
+} GnlAutoplugChoice;
+
+/* The choices made while decoding a given version of a file */
+typedef struct
+{
+  gint64 size;
+  gint64 mtime;
+  GList *choices;
+} GnlAutoplugEntry;
+
+/* uri -> GnlAutoplugEntry, local files only. Each decoder also has a
+ * GnlAutoplugEntry with the factories it tried, set as AUTOPLUG_TRIED data,
+ * which are only cached once the elements are really plugged */
+#define AUTOPLUG_TRIED "gnl-autoplug-tried"
+G_LOCK_DEFINE_STATIC (autoplug_cache);
+static GHashTable *autoplug_cache = NULL;
+static guint64 autoplug_cache_hits = 0;
+static guint64 autoplug_cache_misses = 0;
+
 static gboolean gnl_urisource_prepare (GnlObject * object);
 
+static void gnl_urisource_dispose (GObject * object);
+
+static GstStateChangeReturn
+gnl_urisource_change_state (GstElement * element, GstStateChange transition);
+
 static void
 gnl_urisource_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -82,11 +157,68 @@ gnl_urisource_class_init (GnlURISourceClass * klass)
 
   gobject_class->set_property = GST_DEBUG_FUNCPTR (gnl_urisource_set_property);
   gobject_class->get_property = GST_DEBUG_FUNCPTR (gnl_urisource_get_property);
+  gobject_class->dispose = GST_DEBUG_FUNCPTR (gnl_urisource_dispose);
 
   g_object_class_install_property (gobject_class, ARG_URI,
       g_param_spec_string ("uri", "Uri",
           "Uri of the file to use", NULL, G_PARAM_READWRITE));
 
+  /**
+   * GnlURISource:reuse-decoder
+   *
+   * Whether to hand the decoding chain over to another source with the same
+   * uri and caps when going back to READY, and to take over such a chain
+   * instead of building a new one when going to PAUSED.
+   *
+   * The released chains stay PAUSED in the pool until they are taken over,
+   * evicted by more recently released ones, or no source uses their uri
+   * anymore, see #GnlURISource:pooled-decoders.
+   */
+  g_object_class_install_property (gobject_class, ARG_REUSE_DECODER,
+      g_param_spec_boolean ("reuse-decoder", "Reuse decoder",
+          "Share the decoding chain with the sources using the same uri",
+          FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GnlURISource:autoplug-cache-hits
+   *
+   * Number of times, process-wide, a local file's decoder had to pick an
+   * element for some caps and the autoplug cache made it try the element
+   * plugged last time first.
+   *
+   * The cache doesn't skip typefinding nor the elements' setup, it only
+   * changes the order in which the candidates are tried.
+   */
+  g_object_class_install_property (gobject_class, ARG_AUTOPLUG_CACHE_HITS,
+      g_param_spec_uint64 ("autoplug-cache-hits", "Autoplug cache hits",
+          "Number of element choices reordered by the autoplug cache",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+  /**
+   * GnlURISource:autoplug-cache-misses
+   *
+   * Number of times, process-wide, a local file's decoder had to pick an
+   * element for some caps and the autoplug cache had nothing to suggest.
+   */
+  g_object_class_install_property (gobject_class, ARG_AUTOPLUG_CACHE_MISSES,
+      g_param_spec_uint64 ("autoplug-cache-misses", "Autoplug cache misses",
+          "Number of element choices the autoplug cache knew nothing about",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+  /**
+   * GnlURISource:pooled-decoders
+   *
+   * Number of decoding chains, process-wide, released by sources with
+   * #GnlURISource:reuse-decoder set and kept in the pool.
+   */
+  g_object_class_install_property (gobject_class, ARG_POOLED_DECODERS,
+      g_param_spec_uint ("pooled-decoders", "Pooled decoders",
+          "Number of idle decoding chains kept for reuse",
+          0, G_MAXUINT, 0, G_PARAM_READABLE));
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gnl_urisource_change_state);
+
   gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&gnl_urisource_src_template));
 
@@ -94,26 +226,552 @@ gnl_urisource_class_init (GnlURISourceClass * klass)
 }
 
 static void
-gnl_urisource_init (GnlURISource * urisource)
+autoplug_entry_clear (GnlAutoplugEntry * entry)
 {
-  GstElement *decodebin = NULL;
+  GList *tmp;
 
-  GST_OBJECT_FLAG_SET (urisource, GNL_OBJECT_SOURCE);
+  for (tmp = entry->choices; tmp; tmp = tmp->next) {
+    GnlAutoplugChoice *choice = (GnlAutoplugChoice *) tmp->data;
+
+    gst_caps_unref (choice->caps);
+    gst_object_unref (choice->factory);
+    g_slice_free (GnlAutoplugChoice, choice);
+  }
+
+  g_list_free (entry->choices);
+  entry->choices = NULL;
+}
+
+static void
+autoplug_entry_free (GnlAutoplugEntry * entry)
+{
+  autoplug_entry_clear (entry);
+  g_slice_free (GnlAutoplugEntry, entry);
+}
+
+static gboolean
+get_file_info (const gchar * uri, gint64 * size, gint64 * mtime)
+{
+  gchar *filename = g_filename_from_uri (uri, NULL, NULL);
+  GStatBuf buf;
+  gboolean ret = FALSE;
+
+  if (filename && g_stat (filename, &buf) == 0) {
+    *size = buf.st_size;
+    *mtime = buf.st_mtime;
+    ret = TRUE;
+  }
+
+  g_free (filename);
+
+  return ret;
+}
+
+/* WITH autoplug_cache LOCK TAKEN */
+static gboolean
+autoplug_cache_has_entry (GstElement * decoder)
+{
+  gboolean ret = FALSE;
+  gchar *uri = NULL;
+
+  g_object_get (decoder, "uri", &uri, NULL);
+  if (uri && autoplug_cache)
+    ret = g_hash_table_contains (autoplug_cache, uri);
+  g_free (uri);
+
+  return ret;
+}
+
+/* WITH autoplug_cache LOCK TAKEN */
+static GnlAutoplugChoice *
+autoplug_cache_find (GstElement * decoder, GstCaps * caps)
+{
+  GnlAutoplugEntry *entry = NULL;
+  GList *tmp;
+  gchar *uri = NULL;
+
+  g_object_get (decoder, "uri", &uri, NULL);
+  if (uri && autoplug_cache)
+    entry = g_hash_table_lookup (autoplug_cache, uri);
+  g_free (uri);
+
+  if (!entry)
+    return NULL;
+
+  for (tmp = entry->choices; tmp; tmp = tmp->next)
+    if (gst_caps_is_equal (((GnlAutoplugChoice *) tmp->data)->caps, caps))
+      return (GnlAutoplugChoice *) tmp->data;
+
+  return NULL;
+}
+
+/*
+ * autoplug_cache_check:
+ *
+ * Checks whether the choices cached for @uri are still valid, and sets up
+ * an empty entry to record them otherwise.
+ */
+static void
+autoplug_cache_check (GnlURISource * urisource, const gchar * uri)
+{
+  GObject *decoder = (GObject *) GNL_SOURCE (urisource)->element;
+  GnlAutoplugEntry *entry;
+  gint64 size, mtime;
+
+  /* Only local files can be checked for changes */
+  if (!get_file_info (uri, &size, &mtime))
+    return;
+
+  G_LOCK (autoplug_cache);
+  /* What failed during the previous activations doesn't matter anymore */
+  autoplug_entry_clear (g_object_get_data (decoder, AUTOPLUG_TRIED));
+
+  if (!autoplug_cache)
+    autoplug_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) autoplug_entry_free);
+
+  entry = g_hash_table_lookup (autoplug_cache, uri);
+  if (!entry || entry->size != size || entry->mtime != mtime) {
+    GST_DEBUG_OBJECT (urisource, "No valid autoplug cache entry for %s", uri);
+
+    entry = g_slice_new0 (GnlAutoplugEntry);
+    entry->size = size;
+    entry->mtime = mtime;
+    g_hash_table_insert (autoplug_cache, g_strdup (uri), entry);
+  }
+  G_UNLOCK (autoplug_cache);
+}
+
+/* Notes the factories tried, which might fail to be plugged */
+static gint
+autoplug_select_cb (GstElement * decoder, GstPad * pad, GstCaps * caps,
+    GstElementFactory * factory, gpointer udata)
+{
+  GnlAutoplugEntry *tried;
+  GnlAutoplugChoice *choice;
+
+  G_LOCK (autoplug_cache);
+  if ((tried = g_object_get_data (G_OBJECT (decoder), AUTOPLUG_TRIED))) {
+    choice = g_slice_new0 (GnlAutoplugChoice);
+    choice->caps = gst_caps_ref (caps);
+    choice->factory = gst_object_ref (factory);
+    tried->choices = g_list_prepend (tried->choices, choice);
+  }
+  G_UNLOCK (autoplug_cache);
+
+  /* GST_AUTOPLUG_SELECT_TRY */
+  return 0;
+}
+
+static gboolean
+collect_factory (GValue * item, GValue * ret G_GNUC_UNUSED,
+    GList ** factories)
+{
+  GstElement *element = g_value_get_object (item);
+  GstElementFactory *factory = gst_element_get_factory (element);
+
+  if (factory)
+    *factories = g_list_prepend (*factories, factory);
+
+  return TRUE;
+}
+
+/*
+ * autoplug_pad_added_cb:
+ *
+ * A chain is done, caches the tried factories that ended up in it. The
+ * ones that failed were removed from the decoder already.
+ */
+static void
+autoplug_pad_added_cb (GstElement * decoder, GstPad * pad, gpointer udata)
+{
+  GnlAutoplugEntry *entry = NULL, *tried;
+  GList *factories = NULL, *tmp, *next;
+  GstIterator *elements;
+  gchar *uri = NULL;
+
+  elements = gst_bin_iterate_recurse (GST_BIN (decoder));
+retry:
+  if (gst_iterator_fold (elements, (GstIteratorFoldFunction) collect_factory,
+          NULL, &factories) == GST_ITERATOR_RESYNC) {
+    g_list_free (factories);
+    factories = NULL;
+    gst_iterator_resync (elements);
+    goto retry;
+  }
+  gst_iterator_free (elements);
+
+  g_object_get (decoder, "uri", &uri, NULL);
+
+  G_LOCK (autoplug_cache);
+  if (uri && autoplug_cache)
+    entry = g_hash_table_lookup (autoplug_cache, uri);
+  tried = g_object_get_data (G_OBJECT (decoder), AUTOPLUG_TRIED);
+
+  for (tmp = tried ? tried->choices : NULL; entry && tmp; tmp = next) {
+    GnlAutoplugChoice *choice = (GnlAutoplugChoice *) tmp->data, *cached;
+
+    next = tmp->next;
+    if (!g_list_find (factories, choice->factory))
+      continue;
+
+    tried->choices = g_list_delete_link (tried->choices, tmp);
+    if ((cached = autoplug_cache_find (decoder, choice->caps))) {
+      gst_object_unref (cached->factory);
+      cached->factory = choice->factory;
+      gst_caps_unref (choice->caps);
+      g_slice_free (GnlAutoplugChoice, choice);
+    } else
+      entry->choices = g_list_prepend (entry->choices, choice);
+  }
+  G_UNLOCK (autoplug_cache);
+
+  g_list_free (factories);
+  g_free (uri);
+}
+
+/* Puts the factory that got plugged last time for @caps first */
+static GValueArray *
+autoplug_sort_cb (GstElement * decoder, GstPad * pad, GstCaps * caps,
+    GValueArray * factories, gpointer udata)
+{
+  GnlAutoplugChoice *choice;
+  GstElementFactory *factory = NULL;
+  GValueArray *result = NULL;
+  GValue *value;
+  guint i;
+
+  G_LOCK (autoplug_cache);
+  if ((choice = autoplug_cache_find (decoder, caps)))
+    factory = gst_object_ref (choice->factory);
+  else if (autoplug_cache_has_entry (decoder))
+    autoplug_cache_misses++;
+  G_UNLOCK (autoplug_cache);
+
+  if (!factory)
+    return NULL;
+
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+  for (i = 0; i < factories->n_values; i++) {
+    value = g_value_array_get_nth (factories, i);
+    if (g_value_get_object (value) != factory)
+      continue;
+
+    result = g_value_array_new (factories->n_values);
+    g_value_array_append (result, value);
+    for (i = 0; i < factories->n_values; i++) {
+      if (g_value_get_object (g_value_array_get_nth (factories, i)) != factory)
+        g_value_array_append (result, g_value_array_get_nth (factories, i));
+    }
+    break;
+  }
+  G_GNUC_END_IGNORE_DEPRECATIONS;
+
+  /* Only count the cached choices that are still candidates */
+  G_LOCK (autoplug_cache);
+  if (result)
+    autoplug_cache_hits++;
+  else
+    autoplug_cache_misses++;
+  G_UNLOCK (autoplug_cache);
+
+  gst_object_unref (factory);
+
+  return result;
+}
+
+static void
+gnl_urisource_add_decoder (GnlURISource * urisource, const gchar * uri)
+{
+  GstElement *decodebin = NULL;
 
   /* We create a bin with source and decodebin within */
   decodebin =
       gst_element_factory_make ("uridecodebin", "internal-uridecodebin");
-  g_object_set (decodebin, "expose-all-streams", FALSE, NULL);
+  g_object_set (decodebin, "expose-all-streams", FALSE, "uri", uri, NULL);
+
+  /* Not tied to @urisource, the decoder can end up in another source */
+  g_signal_connect (decodebin, "autoplug-select",
+      G_CALLBACK (autoplug_select_cb), NULL);
+  g_signal_connect (decodebin, "autoplug-sort",
+      G_CALLBACK (autoplug_sort_cb), NULL);
+  g_signal_connect (decodebin, "pad-added",
+      G_CALLBACK (autoplug_pad_added_cb), NULL);
+  g_object_set_data_full (G_OBJECT (decodebin), AUTOPLUG_TRIED,
+      g_slice_new0 (GnlAutoplugEntry), (GDestroyNotify) autoplug_entry_free);
 
   gst_bin_add (GST_BIN (urisource), decodebin);
 }
 
+static void
+gnl_urisource_init (GnlURISource * urisource)
+{
+  GST_OBJECT_FLAG_SET (urisource, GNL_OBJECT_SOURCE);
+
+  gnl_urisource_add_decoder (urisource, NULL);
+}
+
+static void
+pooled_decoder_free (GnlPooledDecoder * pooled)
+{
+  if (pooled->probeid) {
+    gst_element_set_state (pooled->decoder, GST_STATE_NULL);
+    gst_pad_remove_probe (pooled->pad, pooled->probeid);
+  }
+
+  gst_object_unref (pooled->pad);
+  gst_object_unref (pooled->decoder);
+  gst_caps_unref (pooled->caps);
+  g_free (pooled->uri);
+  g_slice_free (GnlPooledDecoder, pooled);
+}
+
+/* WITH decoder_pool LOCK TAKEN */
+static void
+decoder_pool_remove (GnlPooledDecoder * pooled)
+{
+  GList *entries = g_hash_table_lookup (decoder_pool, pooled->uri);
+
+  entries = g_list_remove (entries, pooled);
+  if (entries)
+    g_hash_table_insert (decoder_pool, g_strdup (pooled->uri), entries);
+  else
+    g_hash_table_remove (decoder_pool, pooled->uri);
+
+  g_queue_remove (&decoder_pool_lru, pooled);
+}
+
+/* Registers a source using @uri */
+static void
+decoder_pool_add_user (const gchar * uri)
+{
+  guint users;
+
+  G_LOCK (decoder_pool);
+  if (!decoder_pool_users)
+    decoder_pool_users = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, NULL);
+
+  users = GPOINTER_TO_UINT (g_hash_table_lookup (decoder_pool_users, uri));
+  g_hash_table_insert (decoder_pool_users, g_strdup (uri),
+      GUINT_TO_POINTER (users + 1));
+  G_UNLOCK (decoder_pool);
+}
+
+/* Unregisters a source using @uri, and drops the chains pooled for @uri if
+ * it was the last one */
+static void
+decoder_pool_remove_user (const gchar * uri)
+{
+  GList *drained = NULL, *tmp;
+  guint users;
+
+  G_LOCK (decoder_pool);
+  users = GPOINTER_TO_UINT (g_hash_table_lookup (decoder_pool_users, uri));
+  if (users > 1) {
+    g_hash_table_insert (decoder_pool_users, g_strdup (uri),
+        GUINT_TO_POINTER (users - 1));
+  } else {
+    g_hash_table_remove (decoder_pool_users, uri);
+
+    if (decoder_pool) {
+      /* The lists aren't freed along with the table entries */
+      drained = g_hash_table_lookup (decoder_pool, uri);
+      g_hash_table_remove (decoder_pool, uri);
+      for (tmp = drained; tmp; tmp = tmp->next)
+        g_queue_remove (&decoder_pool_lru, tmp->data);
+    }
+  }
+  G_UNLOCK (decoder_pool);
+
+  if (drained)
+    GST_DEBUG ("Dropping the %u decoders pooled for %s",
+        g_list_length (drained), uri);
+
+  /* Outside of the lock, the decoders go to NULL */
+  g_list_free_full (drained, (GDestroyNotify) pooled_decoder_free);
+}
+
+static GstPadProbeReturn
+pooled_pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
+{
+  GST_LOG_OBJECT (pad, "pooled decoder blocked");
+
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * gnl_urisource_release_decoder:
+ *
+ * Blocks the decoding chain of @urisource, moves it to the pool and gives
+ * @urisource a new one. Only chains that are done exposing their single
+ * source pad are pooled.
+ */
+static void
+gnl_urisource_release_decoder (GnlURISource * urisource)
+{
+  GnlObject *object = (GnlObject *) urisource;
+  GstElement *decoder = GNL_SOURCE (urisource)->element;
+  GnlPooledDecoder *pooled;
+  GstPad *pad = NULL;
+  GList *entries, *evicted = NULL;
+  gchar *uri = NULL;
+
+  if (!decoder)
+    return;
+
+  g_object_get (decoder, "uri", &uri, NULL);
+  if (!uri)
+    return;
+
+  GST_OBJECT_LOCK (decoder);
+  if (decoder->numsrcpads == 1)
+    pad = gst_object_ref (decoder->srcpads->data);
+  GST_OBJECT_UNLOCK (decoder);
+
+  if (!pad) {
+    GST_DEBUG_OBJECT (urisource, "Decoder isn't exposing a single pad");
+    goto beach;
+  }
+
+  GST_DEBUG_OBJECT (urisource, "Releasing decoder %s to the pool",
+      GST_ELEMENT_NAME (decoder));
+
+  pooled = g_slice_new0 (GnlPooledDecoder);
+  pooled->uri = g_strdup (uri);
+  pooled->decoder = gst_object_ref (decoder);
+  pooled->caps = gst_caps_ref (object->caps);
+  pooled->pad = pad;
+  pooled->probeid = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+      (GstPadProbeCallback) pooled_pad_blocked_cb, NULL, NULL);
+
+  gst_bin_remove (GST_BIN (urisource), decoder);
+  gnl_urisource_add_decoder (urisource, uri);
+
+  G_LOCK (decoder_pool);
+  if (!decoder_pool)
+    decoder_pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        NULL);
+
+  /* Make room by evicting the least recently released chains, of this uri
+   * first */
+  entries = g_hash_table_lookup (decoder_pool, uri);
+  if (g_list_length (entries) >= MAX_POOLED_DECODERS_PER_URI) {
+    GnlPooledDecoder *oldest = g_list_last (entries)->data;
+
+    decoder_pool_remove (oldest);
+    evicted = g_list_prepend (evicted, oldest);
+  }
+  if (decoder_pool_lru.length >= MAX_POOLED_DECODERS) {
+    GnlPooledDecoder *oldest = g_queue_peek_tail (&decoder_pool_lru);
+
+    decoder_pool_remove (oldest);
+    evicted = g_list_prepend (evicted, oldest);
+  }
+
+  entries = g_list_prepend (g_hash_table_lookup (decoder_pool, uri), pooled);
+  g_hash_table_insert (decoder_pool, g_strdup (uri), entries);
+  g_queue_push_head (&decoder_pool_lru, pooled);
+  G_UNLOCK (decoder_pool);
+
+  /* Outside of the lock, the decoders go to NULL */
+  g_list_free_full (evicted, (GDestroyNotify) pooled_decoder_free);
+
+beach:
+  g_free (uri);
+}
+
+/*
+ * gnl_urisource_acquire_decoder:
+ *
+ * Replaces the decoding chain of @urisource by a pooled one using the same
+ * uri and caps. The returned #GnlPooledDecoder is still blocked, it is up
+ * to the caller to unblock and free it.
+ */
+static GnlPooledDecoder *
+gnl_urisource_acquire_decoder (GnlURISource * urisource)
+{
+  GnlObject *object = (GnlObject *) urisource;
+  GstElement *decoder = GNL_SOURCE (urisource)->element;
+  GnlPooledDecoder *pooled = NULL;
+  GList *entries, *tmp;
+  gchar *uri = NULL;
+
+  if (!decoder)
+    return NULL;
+
+  g_object_get (decoder, "uri", &uri, NULL);
+  if (!uri)
+    return NULL;
+
+  G_LOCK (decoder_pool);
+  if (decoder_pool) {
+    entries = g_hash_table_lookup (decoder_pool, uri);
+
+    for (tmp = entries; tmp; tmp = tmp->next) {
+      if (gst_caps_is_equal (((GnlPooledDecoder *) tmp->data)->caps,
+              object->caps)) {
+        pooled = (GnlPooledDecoder *) tmp->data;
+        entries = g_list_delete_link (entries, tmp);
+        break;
+      }
+    }
+
+    if (pooled && entries)
+      g_hash_table_insert (decoder_pool, g_strdup (uri), entries);
+    else if (pooled)
+      g_hash_table_remove (decoder_pool, uri);
+    if (pooled)
+      g_queue_remove (&decoder_pool_lru, pooled);
+  }
+  G_UNLOCK (decoder_pool);
+  g_free (uri);
+
+  if (!pooled)
+    return NULL;
+
+  GST_DEBUG_OBJECT (urisource, "Reusing pooled decoder %s",
+      GST_ELEMENT_NAME (pooled->decoder));
+
+  gst_object_ref (decoder);
+  gst_bin_remove (GST_BIN (urisource), decoder);
+  gst_element_set_state (decoder, GST_STATE_NULL);
+  gst_object_unref (decoder);
+
+  gst_bin_add (GST_BIN (urisource), pooled->decoder);
+
+  return pooled;
+}
+
 static inline void
 gnl_urisource_set_uri (GnlURISource * fs, const gchar * uri)
 {
+  /* The chains pooled for the previous uri might not be needed anymore */
+  if (uri)
+    decoder_pool_add_user (uri);
+  if (fs->uri)
+    decoder_pool_remove_user (fs->uri);
+  g_free (fs->uri);
+  fs->uri = g_strdup (uri);
+
   g_object_set (GNL_SOURCE (fs)->element, "uri", uri, NULL);
 }
 
+static void
+gnl_urisource_dispose (GObject * object)
+{
+  GnlURISource *fs = (GnlURISource *) object;
+
+  if (fs->uri) {
+    decoder_pool_remove_user (fs->uri);
+    g_free (fs->uri);
+    fs->uri = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
 static void
 gnl_urisource_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -124,6 +782,9 @@ gnl_urisource_set_property (GObject * object, guint prop_id,
     case ARG_URI:
       gnl_urisource_set_uri (fs, g_value_get_string (value));
       break;
+    case ARG_REUSE_DECODER:
+      fs->reuse_decoder = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -141,6 +802,24 @@ gnl_urisource_get_property (GObject * object, guint prop_id,
       g_object_get_property ((GObject *) GNL_SOURCE (fs)->element, "uri",
           value);
       break;
+    case ARG_REUSE_DECODER:
+      g_value_set_boolean (value, fs->reuse_decoder);
+      break;
+    case ARG_AUTOPLUG_CACHE_HITS:
+      G_LOCK (autoplug_cache);
+      g_value_set_uint64 (value, autoplug_cache_hits);
+      G_UNLOCK (autoplug_cache);
+      break;
+    case ARG_AUTOPLUG_CACHE_MISSES:
+      G_LOCK (autoplug_cache);
+      g_value_set_uint64 (value, autoplug_cache_misses);
+      G_UNLOCK (autoplug_cache);
+      break;
+    case ARG_POOLED_DECODERS:
+      G_LOCK (decoder_pool);
+      g_value_set_uint (value, decoder_pool_lru.length);
+      G_UNLOCK (decoder_pool);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -148,13 +827,46 @@ gnl_urisource_get_property (GObject * object, guint prop_id,
 
 }
 
+static GstStateChangeReturn
+gnl_urisource_change_state (GstElement * element, GstStateChange transition)
+{
+  GnlURISource *urisource = (GnlURISource *) element;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Before the decoder goes to READY and drops its chain */
+      if (urisource->reuse_decoder)
+        gnl_urisource_release_decoder (urisource);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
 static gboolean
 gnl_urisource_prepare (GnlObject * object)
 {
   GnlSource *fs = (GnlSource *) object;
+  GnlPooledDecoder *pooled = NULL;
+  gboolean ret;
 
   GST_DEBUG ("prepare");
 
+  if (((GnlURISource *) object)->reuse_decoder)
+    pooled = gnl_urisource_acquire_decoder ((GnlURISource *) object);
+
+  /* The decoder is about to autoplug from scratch */
+  if (!pooled) {
+    gchar *uri = NULL;
+
+    g_object_get (fs->element, "uri", &uri, NULL);
+    if (uri)
+      autoplug_cache_check ((GnlURISource *) object, uri);
+    g_free (uri);
+  }
+
   /* Set the caps on uridecodebin */
   if (!gst_caps_is_any (object->caps)) {
     GST_DEBUG_OBJECT (object, "Setting uridecodebin caps to %" GST_PTR_FORMAT,
@@ -162,5 +874,19 @@ gnl_urisource_prepare (GnlObject * object)
     g_object_set (fs->element, "caps", object->caps, NULL);
   }
 
-  return GNL_OBJECT_CLASS (parent_class)->prepare (object);
+  ret = GNL_OBJECT_CLASS (parent_class)->prepare (object);
+
+  /* GnlSource now blocks the pad, the flushing seek it gets will restart
+   * the chain at the right position. The chain was usually released at
+   * EOS and has nothing left to push, so don't wait for a buffer to get
+   * blocked before ghosting the pad and seeking it */
+  if (pooled) {
+    gst_pad_remove_probe (pooled->pad, pooled->probeid);
+    pooled->probeid = 0;
+    pooled_decoder_free (pooled);
+    if (ret)
+      gnl_source_ghost_pad_now (fs);
+  }
+
+  return ret;
 }
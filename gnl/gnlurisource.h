@@ -44,6 +44,9 @@ struct _GnlURISource
   GnlSource parent;
 
   gchar *uri;
+
+  /* TRUE if the decoding chain is shared through the decoder pool */
+  gboolean reuse_decoder;
 };
 
 struct _GnlURISourceClass
@@ -0,0 +1,100 @@
+/* Gnonlin
+ *
+ * gnlbulk.c: Benchmark of adding and removing many objects
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+static const guint sizes[] = { 100, 1000, 10000 };
+
+/* Sources laid out one after the other on a few layers */
+static GPtrArray *
+make_sources (guint nb)
+{
+  GPtrArray *sources = g_ptr_array_sized_new (nb);
+  GstElement *source;
+  guint i;
+
+  for (i = 0; i < nb; i++) {
+    source = gst_element_factory_make ("gnlsource", NULL);
+    g_assert (source);
+    g_object_set (source, "start", (guint64) (i / 4) * GST_SECOND,
+        "duration", (guint64) GST_SECOND, "inpoint", (guint64) 0,
+        "priority", (i % 4) + 1, NULL);
+    g_ptr_array_add (sources, gst_object_ref_sink (source));
+  }
+
+  return sources;
+}
+
+static void
+run (guint nb, gboolean bulk)
+{
+  GstElement *comp;
+  GPtrArray *sources;
+  GstClockTime start, added, removed;
+  gboolean ret;
+  guint i;
+
+  comp = gst_element_factory_make ("gnlcomposition", NULL);
+  g_assert (comp);
+  sources = make_sources (nb);
+
+  start = gst_util_get_timestamp ();
+  if (bulk) {
+    g_signal_emit_by_name (comp, "add-objects", sources, &ret);
+  } else {
+    for (i = 0; i < nb; i++)
+      gst_bin_add (GST_BIN (comp), g_ptr_array_index (sources, i));
+    g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  }
+  added = GST_CLOCK_DIFF (start, gst_util_get_timestamp ());
+
+  start = gst_util_get_timestamp ();
+  if (bulk) {
+    g_signal_emit_by_name (comp, "remove-objects", sources, &ret);
+  } else {
+    for (i = 0; i < nb; i++)
+      gst_bin_remove (GST_BIN (comp), g_ptr_array_index (sources, i));
+    g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  }
+  removed = GST_CLOCK_DIFF (start, gst_util_get_timestamp ());
+
+  g_print ("%5u objects, %s: add %" GST_TIME_FORMAT ", remove %"
+      GST_TIME_FORMAT "\n", nb, bulk ? "bulk       " : "per-element",
+      GST_TIME_ARGS (added), GST_TIME_ARGS (removed));
+
+  g_ptr_array_foreach (sources, (GFunc) gst_object_unref, NULL);
+  g_ptr_array_free (sources, TRUE);
+  gst_object_unref (comp);
+}
+
+int
+main (int argc, gchar ** argv)
+{
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    run (sizes[i], FALSE);
+    run (sizes[i], TRUE);
+  }
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* Gnonlin
+ *
+ * gnlstack.c: Benchmark of the composition stack construction
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#define ITERATIONS 10
+
+static const guint layers[] = { 10, 100, 1000 };
+
+/* All the sources overlap, each one starting 1ms after the previous one,
+ * which gives 2 * nb - 1 different stacks of up to nb layers */
+static GstElement *
+make_composition (guint nb, GstElement ** first)
+{
+  GstElement *comp, *source;
+  gboolean ret = FALSE;
+  guint i;
+
+  comp = gst_element_factory_make ("gnlcomposition", NULL);
+  g_assert (comp);
+
+  for (i = 0; i < nb; i++) {
+    source = gst_element_factory_make ("gnlsource", NULL);
+    g_assert (source);
+    g_object_set (source, "start", (guint64) i * GST_MSECOND,
+        "duration", (guint64) 10 * GST_SECOND, "inpoint", (guint64) 0,
+        "priority", i + 1, NULL);
+    gst_bin_add (GST_BIN (comp), source);
+    if (!i)
+      *first = source;
+  }
+
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  g_assert (ret);
+
+  return comp;
+}
+
+static void
+run (guint nb)
+{
+  GstElement *comp, *first = NULL;
+  GstClockTime start, total = 0;
+  GArray *cutlist;
+  gboolean ret;
+  guint i, nbstacks = 2 * nb - 1;
+
+  comp = make_composition (nb, &first);
+
+  for (i = 0; i < ITERATIONS; i++) {
+    /* Modify the timeline so that the cut list gets rebuilt */
+    g_object_set (first, "duration",
+        (guint64) (i % 2 ? 10 * GST_SECOND : 11 * GST_SECOND), NULL);
+    g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+
+    start = gst_util_get_timestamp ();
+    g_signal_emit_by_name (comp, "get-cut-list", &cutlist);
+    total += GST_CLOCK_DIFF (start, gst_util_get_timestamp ());
+
+    g_array_unref (cutlist);
+  }
+
+  g_print ("%4u layers: %" GST_TIME_FORMAT " per cut list, %"
+      G_GUINT64_FORMAT " ns per stack\n", nb,
+      GST_TIME_ARGS (total / ITERATIONS),
+      total / ITERATIONS / nbstacks);
+
+  gst_object_unref (comp);
+}
+
+int
+main (int argc, gchar ** argv)
+{
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 0; i < G_N_ELEMENTS (layers); i++)
+    run (layers[i]);
+
+  return 0;
+}
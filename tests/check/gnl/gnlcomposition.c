@@ -234,6 +234,113 @@ GST_START_TEST (test_remove_invalid_object)
 
 GST_END_TEST;
 
+static void
+check_cut_list (GstElement * comp, guint len, ...)
+{
+  GArray *cutlist = NULL;
+  va_list args;
+  guint i;
+
+  g_signal_emit_by_name (comp, "get-cut-list", &cutlist);
+  fail_unless (cutlist != NULL);
+  fail_unless_equals_int (cutlist->len, len);
+
+  va_start (args, len);
+  for (i = 0; i < len; i++)
+    fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, i),
+        va_arg (args, GstClockTime));
+  va_end (args);
+
+  g_array_unref (cutlist);
+}
+
+GST_START_TEST (test_cut_list)
+{
+  GstElement *comp, *source1, *source2, *source3;
+  GArray *cutlist = NULL;
+  gboolean ret = FALSE;
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+
+  /*
+     source1
+     Start : 0s
+     Duration : 2s
+     Priority : 1
+   */
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+
+  /*
+     source2
+     Start : 1s
+     Duration : 2s
+     Priority : 2
+   */
+  source2 = videotest_gnl_src ("source2", 1 * GST_SECOND, 2 * GST_SECOND, 3,
+      2);
+
+  gst_bin_add_many (GST_BIN (comp), source1, source2, NULL);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+
+  /* source2 is hidden by source1 until 2s */
+  g_signal_emit_by_name (comp, "get-cut-list", &cutlist);
+  fail_unless (cutlist != NULL);
+  fail_unless_equals_int (cutlist->len, 3);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 0), 0);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 1),
+      2 * GST_SECOND);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 2),
+      3 * GST_SECOND);
+  g_array_unref (cutlist);
+
+  /* Move source1 after source2 */
+  g_object_set (source1, "start", 3 * GST_SECOND, NULL);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+
+  g_signal_emit_by_name (comp, "get-cut-list", &cutlist);
+  fail_unless_equals_int (cutlist->len, 3);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 0),
+      1 * GST_SECOND);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 1),
+      3 * GST_SECOND);
+  fail_unless_equals_uint64 (g_array_index (cutlist, GstClockTime, 2),
+      5 * GST_SECOND);
+  g_array_unref (cutlist);
+
+  /* The cut list is now kept up to date as the objects change */
+  source3 = videotest_gnl_src ("source3", 6 * GST_SECOND, 2 * GST_SECOND, 3,
+      1);
+  gst_bin_add (GST_BIN (comp), source3);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+  check_cut_list (comp, 5, 1 * GST_SECOND, 3 * GST_SECOND, 5 * GST_SECOND,
+      6 * GST_SECOND, 8 * GST_SECOND);
+
+  /* Fill the gap */
+  g_object_set (source3, "start", 5 * GST_SECOND, NULL);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+  check_cut_list (comp, 4, 1 * GST_SECOND, 3 * GST_SECOND, 5 * GST_SECOND,
+      7 * GST_SECOND);
+
+  /* Make source2 visible again over source1, then remove it */
+  g_object_set (source2, "priority", 0, "start", 2 * GST_SECOND, NULL);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+  check_cut_list (comp, 4, 2 * GST_SECOND, 4 * GST_SECOND, 5 * GST_SECOND,
+      7 * GST_SECOND);
+
+  gst_bin_remove (GST_BIN (comp), source2);
+  check_cut_list (comp, 3, 3 * GST_SECOND, 5 * GST_SECOND, 7 * GST_SECOND);
+
+  gst_object_unref (comp);
+}
+
+GST_END_TEST;
+
 static GstPadProbeReturn
 pad_block (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
@@ -528,6 +635,598 @@ GST_START_TEST (test_simple_adder)
 
 GST_END_TEST;
 
+GST_START_TEST (test_transaction)
+{
+  GstElement *comp, *source1, *source2;
+  gboolean ret = FALSE;
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  source2 = videotest_gnl_src ("source2", 2 * GST_SECOND, 2 * GST_SECOND, 3,
+      1);
+
+  g_signal_emit_by_name (comp, "begin-transaction");
+  gst_bin_add_many (GST_BIN (comp), source1, source2, NULL);
+
+  /* Nested transaction, nothing happens when leaving it */
+  g_signal_emit_by_name (comp, "begin-transaction");
+  g_object_set (source2, "start", 1 * GST_SECOND, NULL);
+  g_signal_emit_by_name (comp, "end-transaction", &ret);
+  fail_if (ret);
+
+  /* The commit is only recorded */
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_unless (ret);
+  check_start_stop_duration (comp, 0, 0, 0);
+
+  g_signal_emit_by_name (comp, "end-transaction", &ret);
+  fail_unless (ret);
+  check_start_stop_duration (source2, 1 * GST_SECOND, 3 * GST_SECOND,
+      2 * GST_SECOND);
+  check_start_stop_duration (comp, 0, 3 * GST_SECOND, 3 * GST_SECOND);
+
+  /* Unbalanced end-transaction */
+  g_signal_emit_by_name (comp, "end-transaction", &ret);
+  fail_if (ret);
+
+  gst_object_unref (comp);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_add_remove_objects)
+{
+  GstElement *comp, *source1, *source2;
+  GPtrArray *objects;
+  gboolean ret = FALSE;
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  source2 = videotest_gnl_src ("source2", 2 * GST_SECOND, 2 * GST_SECOND, 3,
+      1);
+
+  objects = g_ptr_array_new ();
+  g_ptr_array_add (objects, source1);
+  g_ptr_array_add (objects, source2);
+
+  /* The objects are commited with the composition */
+  g_signal_emit_by_name (comp, "add-objects", objects, &ret);
+  fail_unless (ret);
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (comp), 2);
+  check_start_stop_duration (comp, 0, 4 * GST_SECOND, 4 * GST_SECOND);
+
+  gst_object_ref (source1);
+  gst_object_ref (source2);
+  g_signal_emit_by_name (comp, "remove-objects", objects, &ret);
+  fail_unless (ret);
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (comp), 0);
+  check_start_stop_duration (comp, 0, 0, 0);
+
+  g_ptr_array_free (objects, TRUE);
+  gst_object_unref (source1);
+  gst_object_unref (source2);
+  gst_object_unref (comp);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint commited;
+  gboolean changed;
+} AsyncCommitData;
+
+static void
+commited_cb (GstElement * comp, gboolean changed, AsyncCommitData * data)
+{
+  g_mutex_lock (&data->lock);
+  data->commited++;
+  data->changed = changed;
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
+}
+
+GST_START_TEST (test_commit_async)
+{
+  GstElement *comp, *source1, *source2;
+  AsyncCommitData data = { {0,}, };
+
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+  g_signal_connect (comp, "commited", G_CALLBACK (commited_cb), &data);
+
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  source2 = videotest_gnl_src ("source2", 2 * GST_SECOND, 2 * GST_SECOND, 3,
+      1);
+  gst_bin_add_many (GST_BIN (comp), source1, source2, NULL);
+
+  /* The changes are only applied from another thread */
+  g_mutex_lock (&data.lock);
+  g_signal_emit_by_name (comp, "commit-async", TRUE);
+  while (!data.commited)
+    g_cond_wait (&data.cond, &data.lock);
+  g_mutex_unlock (&data.lock);
+
+  fail_unless (data.changed);
+  check_start_stop_duration (comp, 0, 4 * GST_SECOND, 4 * GST_SECOND);
+
+  gst_object_unref (comp);
+
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_commit_async_transaction)
+{
+  GstElement *comp, *source1;
+  AsyncCommitData data = { {0,}, };
+  gboolean ret = FALSE;
+
+  g_mutex_init (&data.lock);
+  g_cond_init (&data.cond);
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+  g_signal_connect (comp, "commited", G_CALLBACK (commited_cb), &data);
+
+  g_signal_emit_by_name (comp, "begin-transaction");
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  gst_bin_add (GST_BIN (comp), source1);
+  g_signal_emit_by_name (comp, "commit-async", TRUE);
+
+  /* The commit waits for the transaction, it can't be notified yet */
+  g_usleep (G_USEC_PER_SEC / 20);
+  g_mutex_lock (&data.lock);
+  fail_unless_equals_int (data.commited, 0);
+  g_mutex_unlock (&data.lock);
+  check_start_stop_duration (comp, 0, 0, 0);
+
+  /* Notified once the transaction is over */
+  g_signal_emit_by_name (comp, "end-transaction", &ret);
+  fail_unless (ret);
+
+  g_mutex_lock (&data.lock);
+  while (!data.commited)
+    g_cond_wait (&data.cond, &data.lock);
+  g_mutex_unlock (&data.lock);
+
+  fail_unless_equals_int (data.commited, 1);
+  fail_unless (data.changed);
+  check_start_stop_duration (comp, 0, 2 * GST_SECOND, 2 * GST_SECOND);
+
+  gst_object_unref (comp);
+
+  g_mutex_clear (&data.lock);
+  g_cond_clear (&data.cond);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  gint64 last;                  /* Monotonic time of the last buffer */
+  gint64 gap;                   /* Wait for the first buffer of source2 */
+} GapData;
+
+static void
+gap_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GapData * data)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (data->gap < 0 && GST_BUFFER_PTS (buffer) >= GST_SECOND)
+    data->gap = now - data->last;
+  data->last = now;
+}
+
+GST_START_TEST (test_lookahead_seek)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstElement *pipeline, *comp, *sink, *source1, *source2;
+  GapData data = { 0, -1 };
+  gboolean ret;
+
+  pipeline = gst_pipeline_new (NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+  g_object_set (comp, "lookahead", TRUE, NULL);
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (gap_handoff_cb), &data);
+  gst_bin_add_many (GST_BIN (pipeline), comp, sink, NULL);
+
+  source1 = videotest_gnl_src ("source1", 0, 1 * GST_SECOND, 2, 1);
+  source2 = videotest_gnl_src ("source2", 1 * GST_SECOND, 1 * GST_SECOND, 3,
+      1);
+  gst_bin_add_many (GST_BIN (comp), source1, source2, NULL);
+
+  /* Count the seeks source2 gets */
+  seek_events = 0;
+  g_signal_connect (source2, "pad-added",
+      G_CALLBACK (on_source1_pad_added_cb), NULL);
+  g_signal_connect (comp, "pad-added",
+      G_CALLBACK (on_composition_pad_added_cb), sink);
+
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  /* source2 was seeked while prerolling, moving on to it didn't seek it
+   * again */
+  fail_unless_equals_int (seek_events, 1);
+
+  GST_INFO ("Waited %" G_GINT64_FORMAT " us for the first buffer of source2",
+      data.gap);
+  fail_unless (data.gap >= 0);
+  fail_unless (data.gap < G_USEC_PER_SEC);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+#define N_SCRUB_SEEKS 10
+
+GST_START_TEST (test_coalesce_seeks)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstElement *pipeline, *comp, *sink, *source1;
+  guint64 dropped = 0;
+  gint i, before, handled = 0;
+  gboolean ret;
+
+  pipeline = gst_pipeline_new (NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+  g_object_set (comp, "coalesce-seeks", TRUE, NULL);
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), comp, sink, NULL);
+
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  gst_bin_add (GST_BIN (comp), source1);
+
+  seek_events = 0;
+  g_signal_connect (source1, "pad-added",
+      G_CALLBACK (on_source1_pad_added_cb), NULL);
+  g_signal_connect (comp, "pad-added",
+      G_CALLBACK (on_composition_pad_added_cb), sink);
+
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  /* Scrub, each seek returns at once instead of waiting for the previous
+   * ones to be handled */
+  before = seek_events;
+  for (i = 1; i <= N_SCRUB_SEEKS; i++) {
+    fail_unless (gst_element_seek_simple (sink, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH, i * GST_SECOND / (N_SCRUB_SEEKS + 1)));
+  }
+
+  /* Wait for the seek pool to be done with them */
+  for (i = 0; i < 500; i++) {
+    g_object_get (comp, "dropped-seeks", &dropped, NULL);
+    handled = seek_events - before;
+    if (handled + dropped == N_SCRUB_SEEKS)
+      break;
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+
+  /* The intermediate seeks were overtaken and never reached the source */
+  GST_INFO ("%d seeks handled, %" G_GUINT64_FORMAT " dropped", handled,
+      dropped);
+  fail_unless_equals_int (handled + dropped, N_SCRUB_SEEKS);
+  fail_unless (dropped > 0);
+  fail_unless (handled < N_SCRUB_SEEKS);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GMutex lock;
+  GArray *flags;                /* Flags of the seeks source1 got */
+} SeekFlagsData;
+
+static GstPadProbeReturn
+seek_flags_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    SeekFlagsData * data)
+{
+  GstSeekFlags flags;
+
+  if (GST_EVENT_TYPE (info->data) == GST_EVENT_SEEK) {
+    gst_event_parse_seek (info->data, NULL, NULL, &flags, NULL, NULL, NULL,
+        NULL);
+    g_mutex_lock (&data->lock);
+    g_array_append_val (data->flags, flags);
+    g_mutex_unlock (&data->lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+seek_flags_pad_added_cb (GstElement * source, GstPad * pad,
+    SeekFlagsData * data)
+{
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      (GstPadProbeCallback) seek_flags_probe_cb, data, NULL);
+}
+
+/* Returns the flags of the @n-th seek source1 got, or -1 */
+static gint
+nth_seek_flags (SeekFlagsData * data, guint n)
+{
+  gint flags = -1;
+
+  g_mutex_lock (&data->lock);
+  if (n < data->flags->len)
+    flags = g_array_index (data->flags, GstSeekFlags, n);
+  g_mutex_unlock (&data->lock);
+
+  return flags;
+}
+
+static guint
+n_seeks (SeekFlagsData * data)
+{
+  guint n;
+
+  g_mutex_lock (&data->lock);
+  n = data->flags->len;
+  g_mutex_unlock (&data->lock);
+
+  return n;
+}
+
+#define IS_ACCURATE(flags) \
+    (((flags) & GST_SEEK_FLAG_ACCURATE) && !((flags) & GST_SEEK_FLAG_KEY_UNIT))
+#define IS_KEYFRAME(flags) \
+    (((flags) & GST_SEEK_FLAG_KEY_UNIT) && !((flags) & GST_SEEK_FLAG_ACCURATE))
+
+/* Returns a prerolled pipeline with a composition holding source1, whose
+ * seeks get recorded in @data */
+static GstElement *
+preroll_seek_flags_pipeline (SeekFlagsData * data, GstElement ** pcomp,
+    GstElement ** psink)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstElement *pipeline, *comp, *sink, *source1;
+  gboolean ret;
+
+  g_mutex_init (&data->lock);
+  data->flags = g_array_new (FALSE, FALSE, sizeof (GstSeekFlags));
+
+  pipeline = gst_pipeline_new (NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition",
+      "test_composition");
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), comp, sink, NULL);
+
+  source1 = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  gst_bin_add (GST_BIN (comp), source1);
+
+  g_signal_connect (source1, "pad-added",
+      G_CALLBACK (seek_flags_pad_added_cb), data);
+  g_signal_connect (comp, "pad-added",
+      G_CALLBACK (on_composition_pad_added_cb), sink);
+
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  /* The initial seek is always accurate */
+  fail_unless (n_seeks (data) > 0);
+  fail_unless (IS_ACCURATE (nth_seek_flags (data, 0)));
+
+  gst_object_unref (bus);
+  *pcomp = comp;
+  *psink = sink;
+
+  return pipeline;
+}
+
+/* Prerolls a composition with the @accuracy seek-accuracy, seeks it from
+ * the sink and returns the number of seeks source1 got until then */
+static guint
+seek_with_accuracy (const gchar * accuracy, SeekFlagsData * data,
+    GstElement ** ppipeline)
+{
+  GstElement *comp, *sink;
+  guint n;
+
+  *ppipeline = preroll_seek_flags_pipeline (data, &comp, &sink);
+  gst_util_set_object_arg (G_OBJECT (comp), "seek-accuracy", accuracy);
+
+  n = n_seeks (data);
+  fail_unless (gst_element_seek_simple (sink, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SECOND / 2));
+  fail_unless_equals_int (n_seeks (data), n + 1);
+
+  return n + 1;
+}
+
+static void
+seek_flags_data_clear (SeekFlagsData * data, GstElement * pipeline)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_array_free (data->flags, TRUE);
+  g_mutex_clear (&data->lock);
+}
+
+GST_START_TEST (test_seek_accuracy_accurate)
+{
+  SeekFlagsData data;
+  GstElement *pipeline;
+  guint n;
+
+  n = seek_with_accuracy ("accurate", &data, &pipeline);
+  fail_unless (IS_ACCURATE (nth_seek_flags (&data, n - 1)));
+
+  seek_flags_data_clear (&data, pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_seek_accuracy_keyframe)
+{
+  SeekFlagsData data;
+  GstElement *pipeline;
+  guint n;
+
+  n = seek_with_accuracy ("keyframe", &data, &pipeline);
+  fail_unless (IS_KEYFRAME (nth_seek_flags (&data, n - 1)));
+
+  /* Never refined */
+  g_usleep (G_USEC_PER_SEC / 2);
+  fail_unless_equals_int (n_seeks (&data), n);
+
+  seek_flags_data_clear (&data, pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_seek_accuracy_refine)
+{
+  SeekFlagsData data;
+  GstElement *pipeline, *comp, *sink;
+  guint i, n;
+
+  n = seek_with_accuracy ("refine", &data, &pipeline);
+  fail_unless (IS_KEYFRAME (nth_seek_flags (&data, n - 1)));
+
+  /* Refined once the seeks stop */
+  for (i = 0; i < 200 && n_seeks (&data) == n; i++)
+    g_usleep (G_USEC_PER_SEC / 100);
+  fail_unless_equals_int (n_seeks (&data), n + 1);
+  fail_unless (IS_ACCURATE (nth_seek_flags (&data, n)));
+  n++;
+
+  /* An accurate seek cancels the refinement of the previous one */
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  comp = gst_bin_get_by_name (GST_BIN (pipeline), "test_composition");
+  fail_unless (gst_element_seek_simple (sink, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SECOND));
+  gst_util_set_object_arg (G_OBJECT (comp), "seek-accuracy", "accurate");
+  fail_unless (gst_element_seek_simple (sink, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SECOND));
+  gst_util_set_object_arg (G_OBJECT (comp), "seek-accuracy", "refine");
+  n += 2;
+  fail_unless_equals_int (n_seeks (&data), n);
+  fail_unless (IS_KEYFRAME (nth_seek_flags (&data, n - 2)));
+  fail_unless (IS_ACCURATE (nth_seek_flags (&data, n - 1)));
+  g_usleep (G_USEC_PER_SEC / 2);
+  fail_unless_equals_int (n_seeks (&data), n);
+
+  /* So does starting playback */
+  fail_unless (gst_element_seek_simple (sink, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SECOND / 2));
+  n++;
+  fail_unless (IS_KEYFRAME (nth_seek_flags (&data, n - 1)));
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_usleep (G_USEC_PER_SEC / 2);
+  fail_unless_equals_int (n_seeks (&data), n);
+
+  gst_object_unref (comp);
+  gst_object_unref (sink);
+  seek_flags_data_clear (&data, pipeline);
+}
+
+GST_END_TEST;
+
+/* Seeks at @rate and returns the flags of the seek source1 got */
+static gint
+seek_at_rate (GstElement * sink, SeekFlagsData * data, gdouble rate)
+{
+  guint n = n_seeks (data);
+
+  fail_unless (gst_element_seek (sink, rate, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET,
+          2 * GST_SECOND));
+  fail_unless_equals_int (n_seeks (data), n + 1);
+
+  return nth_seek_flags (data, n);
+}
+
+#define IS_TRICKMODE(flags) \
+    (IS_KEYFRAME (flags) && ((flags) & GST_SEEK_FLAG_SKIP))
+
+GST_START_TEST (test_trickmode_rate)
+{
+  SeekFlagsData data;
+  GstElement *pipeline, *comp, *sink;
+  gint flags;
+
+  pipeline = preroll_seek_flags_pipeline (&data, &comp, &sink);
+  g_object_set (comp, "trickmode-rate", 2.0, NULL);
+
+  /* Below the trick mode rate, the sources decode every frame */
+  flags = seek_at_rate (sink, &data, 1.5);
+  fail_unless (IS_ACCURATE (flags));
+  fail_if (flags & GST_SEEK_FLAG_SKIP);
+  flags = seek_at_rate (sink, &data, -1.5);
+  fail_unless (IS_ACCURATE (flags));
+  fail_if (flags & GST_SEEK_FLAG_SKIP);
+
+  /* From it on, in both directions, only the keyframes */
+  fail_unless (IS_TRICKMODE (seek_at_rate (sink, &data, 2.0)));
+  fail_unless (IS_TRICKMODE (seek_at_rate (sink, &data, 4.0)));
+  fail_unless (IS_TRICKMODE (seek_at_rate (sink, &data, -4.0)));
+
+  /* And back */
+  fail_unless (IS_ACCURATE (seek_at_rate (sink, &data, 1.0)));
+
+  seek_flags_data_clear (&data, pipeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 gnonlin_suite (void)
 {
@@ -540,6 +1239,17 @@ gnonlin_suite (void)
   g_mutex_init (&pad_added_lock);
   tcase_add_test (tc_chain, test_change_object_start_stop_in_current_stack);
   tcase_add_test (tc_chain, test_remove_invalid_object);
+  tcase_add_test (tc_chain, test_cut_list);
+  tcase_add_test (tc_chain, test_transaction);
+  tcase_add_test (tc_chain, test_add_remove_objects);
+  tcase_add_test (tc_chain, test_commit_async);
+  tcase_add_test (tc_chain, test_commit_async_transaction);
+  tcase_add_test (tc_chain, test_lookahead_seek);
+  tcase_add_test (tc_chain, test_coalesce_seeks);
+  tcase_add_test (tc_chain, test_seek_accuracy_accurate);
+  tcase_add_test (tc_chain, test_seek_accuracy_keyframe);
+  tcase_add_test (tc_chain, test_seek_accuracy_refine);
+  tcase_add_test (tc_chain, test_trickmode_rate);
   if (gst_registry_check_feature_version (gst_registry_get (), "videomixer", 0,
           11, 0)) {
     tcase_add_test (tc_chain, test_no_more_pads_race);
@@ -125,7 +125,8 @@ fill_pipeline_and_check (GstElement * comp, GList * segments)
   g_free (collect);
 }
 
-GST_START_TEST (test_simple_operation)
+static void
+test_simple_operation_full (gboolean parallel_activation)
 {
   gboolean ret = FALSE;
   GstElement *comp, *oper, *source;
@@ -133,6 +134,7 @@ GST_START_TEST (test_simple_operation)
 
   comp =
       gst_element_factory_make_or_warn ("gnlcomposition", "test_composition");
+  g_object_set (comp, "parallel-activation", parallel_activation, NULL);
 
   /* TOPOLOGY
    *
@@ -210,6 +212,18 @@ GST_START_TEST (test_simple_operation)
   fill_pipeline_and_check (comp, segments);
 }
 
+GST_START_TEST (test_simple_operation)
+{
+  test_simple_operation_full (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_simple_operation_parallel_activation)
+{
+  test_simple_operation_full (TRUE);
+}
+
 GST_END_TEST;
 
 GST_START_TEST (test_pyramid_operations)
@@ -682,6 +696,7 @@ gnonlin_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_simple_operation);
+  tcase_add_test (tc_chain, test_simple_operation_parallel_activation);
   tcase_add_test (tc_chain, test_pyramid_operations);
   tcase_add_test (tc_chain, test_pyramid_operations2);
   tcase_add_test (tc_chain, test_pyramid_operations_expandable);
@@ -1,3 +1,7 @@
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
 #include "common.h"
 
 GST_START_TEST (test_simple_videotestsrc)
@@ -202,6 +206,348 @@ GST_START_TEST (test_videotestsrc_in_bin)
 
 GST_END_TEST;
 
+/* One second of 8 kHz mono silence */
+static gchar *
+write_wav_file (void)
+{
+  guint8 header[44] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+    'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0, 0x40, 0x1f, 0, 0,
+    0x80, 0x3e, 0, 0, 2, 0, 16, 0, 'd', 'a', 't', 'a', 0, 0, 0, 0
+  };
+  guint32 datasize = 16000;
+  gchar *contents, *filename;
+  gint fd;
+
+  GST_WRITE_UINT32_LE (header + 4, 36 + datasize);
+  GST_WRITE_UINT32_LE (header + 40, datasize);
+  contents = g_malloc0 (sizeof (header) + datasize);
+  memcpy (contents, header, sizeof (header));
+
+  fd = g_file_open_tmp ("gnlsource-XXXXXX.wav", &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (filename, contents,
+          sizeof (header) + datasize, NULL));
+  g_free (contents);
+
+  return filename;
+}
+
+static void
+link_to_sink_cb (GstElement * source, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  fail_unless (gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+}
+
+static guint
+get_pooled_decoders (void)
+{
+  GstElement *source;
+  guint pooled;
+
+  source = gst_element_factory_make_or_warn ("gnlurisource", NULL);
+  g_object_get (source, "pooled-decoders", &pooled, NULL);
+  gst_object_unref (source);
+
+  return pooled;
+}
+
+GST_START_TEST (test_decoder_pool_drained)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstElement *pipeline, *source1, *source2, *sink;
+  gchar *filename, *uri;
+
+  filename = write_wav_file ();
+  uri = gst_filename_to_uri (filename, NULL);
+  fail_unless_equals_int (get_pooled_decoders (), 0);
+
+  pipeline = gst_pipeline_new ("test_pipeline");
+  bus = gst_element_get_bus (pipeline);
+
+  source1 = gst_element_factory_make_or_warn ("gnlurisource", "source1");
+  g_object_set (source1, "uri", uri, "reuse-decoder", TRUE,
+      "start", (guint64) 0, "duration", (gint64) GST_SECOND / 2,
+      "inpoint", (guint64) 0, NULL);
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), source1, sink, NULL);
+  g_signal_connect (source1, "pad-added", G_CALLBACK (link_to_sink_cb), sink);
+
+  /* Another source using the same file, which doesn't play */
+  source2 = gst_element_factory_make_or_warn ("gnlurisource", "source2");
+  gst_object_ref_sink (source2);
+  g_object_set (source2, "uri", uri, NULL);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  /* Going back to READY releases the chain to the pool */
+  fail_if (gst_element_set_state (pipeline, GST_STATE_READY)
+      == GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (get_pooled_decoders (), 1);
+
+  /* source2 still uses the file */
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  fail_unless_equals_int (get_pooled_decoders (), 1);
+
+  /* Nothing uses it anymore */
+  gst_object_unref (source2);
+  fail_unless_equals_int (get_pooled_decoders (), 0);
+
+  gst_object_unref (bus);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+/* Returns the decoding chain of @source, with a reference */
+static GstElement *
+get_decoder (GstElement * source)
+{
+  GstIterator *it;
+  GValue item = { 0, };
+  GstElement *decoder;
+
+  it = gst_bin_iterate_elements (GST_BIN (source));
+  fail_unless (gst_iterator_next (it, &item) == GST_ITERATOR_OK);
+  decoder = g_value_dup_object (&item);
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return decoder;
+}
+
+GST_START_TEST (test_decoder_pool_reused)
+{
+  GstBus *bus;
+  GstMessage *message;
+  GstElement *pipeline, *comp, *source1, *source2, *sink, *decoder, *reused;
+  gchar *filename, *uri;
+  gboolean ret;
+
+  filename = write_wav_file ();
+  uri = gst_filename_to_uri (filename, NULL);
+
+  pipeline = gst_pipeline_new ("test_pipeline");
+  bus = gst_element_get_bus (pipeline);
+
+  comp = gst_element_factory_make_or_warn ("gnlcomposition", "composition");
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), comp, sink, NULL);
+  g_signal_connect (comp, "pad-added", G_CALLBACK (link_to_sink_cb), sink);
+
+  /* Two halves of the same file, one after the other */
+  source1 = gst_element_factory_make_or_warn ("gnlurisource", "source1");
+  g_object_set (source1, "uri", uri, "reuse-decoder", TRUE,
+      "start", (guint64) 0, "duration", (gint64) GST_SECOND / 2,
+      "inpoint", (guint64) 0, NULL);
+  source2 = gst_element_factory_make_or_warn ("gnlurisource", "source2");
+  g_object_set (source2, "uri", uri, "reuse-decoder", TRUE,
+      "start", (guint64) GST_SECOND / 2, "duration", (gint64) GST_SECOND / 2,
+      "inpoint", (guint64) GST_SECOND / 2, NULL);
+  gst_bin_add_many (GST_BIN (comp), source1, source2, NULL);
+  g_signal_emit_by_name (comp, "commit", TRUE, &ret);
+
+  decoder = get_decoder (source1);
+
+  /* source1 releases its chain at EOS, source2 takes it over and plays
+   * it instead of waiting for it forever */
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL, "Timed out playing the reused decoder");
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  reused = get_decoder (source2);
+  fail_unless (reused == decoder);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (reused);
+  gst_object_unref (decoder);
+  gst_object_unref (pipeline);
+  gst_object_unref (bus);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+static guint64
+get_autoplug_cache_hits (void)
+{
+  GstElement *source;
+  guint64 hits;
+
+  source = gst_element_factory_make_or_warn ("gnlurisource", NULL);
+  g_object_get (source, "autoplug-cache-hits", &hits, NULL);
+  gst_object_unref (source);
+
+  return hits;
+}
+
+/* Prerolls @pipeline, then brings it back to READY */
+static void
+activate_once (GstElement * pipeline, GstBus * bus)
+{
+  GstMessage *message;
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_READY)
+      == GST_STATE_CHANGE_FAILURE);
+}
+
+GST_START_TEST (test_autoplug_cache)
+{
+  GstBus *bus;
+  GstElement *pipeline, *source1, *sink;
+  gchar *filename, *uri;
+  guint64 hits;
+
+  filename = write_wav_file ();
+  uri = gst_filename_to_uri (filename, NULL);
+
+  pipeline = gst_pipeline_new ("test_pipeline");
+  bus = gst_element_get_bus (pipeline);
+
+  source1 = gst_element_factory_make_or_warn ("gnlurisource", "source1");
+  g_object_set (source1, "uri", uri, "start", (guint64) 0,
+      "duration", (gint64) GST_SECOND / 2, "inpoint", (guint64) 0, NULL);
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), source1, sink, NULL);
+  g_signal_connect (source1, "pad-added", G_CALLBACK (link_to_sink_cb), sink);
+
+  /* Nothing known about the file yet */
+  hits = get_autoplug_cache_hits ();
+  activate_once (pipeline, bus);
+  fail_unless (get_autoplug_cache_hits () == hits);
+
+  /* The elements plugged the first time get tried first */
+  activate_once (pipeline, bus);
+  fail_unless (get_autoplug_cache_hits () > hits);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (bus);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+static gint upstream_seeks;
+
+static GstPadProbeReturn
+count_seeks_cb (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
+{
+  if (GST_EVENT_TYPE (info->data) == GST_EVENT_SEEK)
+    g_atomic_int_inc (&upstream_seeks);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Plays the whole source backwards and waits for the end */
+static void
+play_reverse (GstElement * pipeline, GstElement * sink, GstBus * bus)
+{
+  GstMessage *message;
+
+  fail_unless (gst_element_seek (sink, -1.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, GST_SEEK_TYPE_SET, 0,
+          GST_SEEK_TYPE_SET, 2 * GST_SECOND));
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING)
+      == GST_STATE_CHANGE_FAILURE);
+
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+}
+
+GST_START_TEST (test_reverse_cache)
+{
+  GstElement *pipeline, *gnlsource, *sink, *videotestsrc;
+  GstIterator *it;
+  GValue item = { 0, };
+  GstMessage *message;
+  GstBus *bus;
+  GstPad *srcpad;
+  gint seeks;
+
+  pipeline = gst_pipeline_new ("test_pipeline");
+  bus = gst_element_get_bus (pipeline);
+
+  gnlsource = videotest_gnl_src ("source1", 0, 2 * GST_SECOND, 2, 1);
+  g_object_set (gnlsource, "reverse-cache-size", (guint64) 64 * 1024 * 1024,
+      NULL);
+  sink = gst_element_factory_make_or_warn ("fakesink", "sink");
+  gst_bin_add_many (GST_BIN (pipeline), gnlsource, sink, NULL);
+  g_signal_connect (gnlsource, "pad-added", G_CALLBACK (link_to_sink_cb),
+      sink);
+
+  /* Count the seeks reaching the decoder */
+  it = gst_bin_iterate_elements (GST_BIN (gnlsource));
+  fail_unless (gst_iterator_next (it, &item) == GST_ITERATOR_OK);
+  videotestsrc = g_value_get_object (&item);
+  srcpad = gst_element_get_static_pad (videotestsrc, "src");
+  g_value_unset (&item);
+  gst_iterator_free (it);
+  upstream_seeks = 0;
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      (GstPadProbeCallback) count_seeks_cb, NULL, NULL);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED)
+      == GST_STATE_CHANGE_FAILURE);
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    fail_error_message (message);
+  gst_message_unref (message);
+
+  /* The first time the decoder plays it backwards */
+  seeks = g_atomic_int_get (&upstream_seeks);
+  play_reverse (pipeline, sink, bus);
+  fail_unless (g_atomic_int_get (&upstream_seeks) > seeks);
+
+  /* The second time it all comes from the cache */
+  seeks = g_atomic_int_get (&upstream_seeks);
+  play_reverse (pipeline, sink, bus);
+  fail_unless_equals_int (g_atomic_int_get (&upstream_seeks), seeks);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_NULL)
+      == GST_STATE_CHANGE_FAILURE);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
 static Suite *
 gnonlin_suite (void)
 {
@@ -213,6 +559,16 @@ gnonlin_suite (void)
   if (0)
     tcase_add_test (tc_chain, test_simple_videotestsrc);
   tcase_add_test (tc_chain, test_videotestsrc_in_bin);
+  tcase_add_test (tc_chain, test_reverse_cache);
+
+  if (gst_registry_check_feature_version (gst_registry_get (), "wavparse", 1,
+          0, 0)) {
+    tcase_add_test (tc_chain, test_decoder_pool_drained);
+    tcase_add_test (tc_chain, test_decoder_pool_reused);
+    tcase_add_test (tc_chain, test_autoplug_cache);
+  } else {
+    GST_WARNING ("wavparse element not available, skipping 3 tests");
+  }
 
   return s;
 }
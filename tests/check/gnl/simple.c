@@ -183,8 +183,28 @@ test_time_duration_full (void)
   gst_object_unref (comp);
 }
 
+typedef struct
+{
+  gboolean gotbuffer;
+  gint flushes;
+} FlushCount;
+
+/* Counts the flushes once data started flowing */
+static GstPadProbeReturn
+flush_count_probe (GstPad * pad, GstPadProbeInfo * info, FlushCount * count)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    count->gotbuffer = TRUE;
+  else if (count->gotbuffer &&
+      GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP)
+    count->flushes++;
+
+  return GST_PAD_PROBE_OK;
+}
+
 static void
-test_one_after_other_full (void)
+test_one_after_other_full (gboolean shared_scheduler, gboolean gapless,
+    gboolean segment_chaining)
 {
   GstElement *pipeline;
   GstElement *comp, *sink, *source1, *source2;
@@ -193,6 +213,7 @@ test_one_after_other_full (void)
   GstMessage *message;
   gboolean carry_on = TRUE;
   GstPad *sinkpad;
+  FlushCount count = { FALSE, 0 };
 
   gboolean ret = FALSE;
 
@@ -200,6 +221,8 @@ test_one_after_other_full (void)
   comp =
       gst_element_factory_make_or_warn ("gnlcomposition", "test_composition");
   fail_if (comp == NULL);
+  g_object_set (comp, "shared-scheduler", shared_scheduler, "gapless",
+      gapless, "segment-chaining", segment_chaining, NULL);
 
   /*
      Source 1
@@ -288,6 +311,9 @@ test_one_after_other_full (void)
   sinkpad = gst_element_get_static_pad (sink, "sink");
   gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM,
       (GstPadProbeCallback) sinkpad_probe, collect, NULL);
+  gst_pad_add_probe (sinkpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) flush_count_probe, &count, NULL);
 
   bus = gst_element_get_bus (GST_ELEMENT (pipeline));
 
@@ -329,6 +355,10 @@ test_one_after_other_full (void)
           GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
 
   fail_if (collect->expected_segments != NULL);
+  if (gapless)
+    fail_unless_equals_int (count.flushes, 0);
+  else
+    fail_unless (count.flushes > 0);
 
   GST_DEBUG ("Resetted pipeline to READY");
 
@@ -753,7 +783,28 @@ GST_END_TEST;
 
 GST_START_TEST (test_one_after_other)
 {
-  test_one_after_other_full ();
+  test_one_after_other_full (FALSE, FALSE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_one_after_other_shared_scheduler)
+{
+  test_one_after_other_full (TRUE, FALSE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_one_after_other_gapless)
+{
+  test_one_after_other_full (FALSE, TRUE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_one_after_other_segment_chaining)
+{
+  test_one_after_other_full (FALSE, FALSE, TRUE);
 }
 
 GST_END_TEST;
@@ -783,6 +834,9 @@ gnonlin_suite (void)
   tcase_add_test (tc_chain, test_time_duration);
   tcase_add_test (tc_chain, test_simplest);
   tcase_add_test (tc_chain, test_one_after_other);
+  tcase_add_test (tc_chain, test_one_after_other_shared_scheduler);
+  tcase_add_test (tc_chain, test_one_after_other_gapless);
+  tcase_add_test (tc_chain, test_one_after_other_segment_chaining);
   tcase_add_test (tc_chain, test_one_under_another);
   tcase_add_test (tc_chain, test_one_bin_after_other);
   return s;